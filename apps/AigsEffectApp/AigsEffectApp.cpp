@@ -31,6 +31,12 @@
 #include <string>
 #include <vector>
 
+#include "allocCounter.h"
+#include "appLog.h"
+#include "cudaGraphLoader.h"
+#include "frameGraph.h"
+#include "latestFrameReader.h"
+#include "nvCVLoggerExamples.h"
 #include "nvCVOpenCV.h"
 #include "nvVFXBackgroundBlur.h"
 #include "nvVFXGreenScreen.h"
@@ -72,6 +78,7 @@ bool FLAG_show = false;
 bool FLAG_verbose = false;
 bool FLAG_webcam = false;
 bool FLAG_cudaGraph = false;
+bool FLAG_checkAllocs = false;
 int FLAG_compMode = 3 /* compWhite */;
 int FLAG_mode = 0;
 int FLAG_logLevel = NVCV_LOG_ERROR;
@@ -164,7 +171,9 @@ static void Usage() {
       "                               5 (composite over a specified background image - compBG),\n"
       "                               6 (blur the background of the image - compBlur) }\n"
       "  --blur_strength=[0-1]      strength of the background blur, when applicable\n"
-      "  --cuda_graph               Enable cuda graph.\n"
+      "  --cuda_graph               replay each frame's upload, matting, composite and download from a CUDA graph,\n"
+      "                             or else the matting kernels alone\n"
+      "  --check_allocs             fail if a video allocates any cv::Mat after its first frame\n"
       "  --log=<file>               log SDK errors to a file, \"stderr\" or \"\" (default stderr)\n"
       "  --log_level=<N>            the desired log level: {0, 1, 2, 3} = {FATAL, ERROR, WARNING, INFO}, respectively "
       "(default 1)\n");
@@ -194,6 +203,7 @@ static int ParseMyArgs(int argc, char** argv) {
                 GetFlagArgVal("comp_mode", arg, &FLAG_compMode) ||          //
                 GetFlagArgVal("blur_strength", arg, &FLAG_blurStrength) ||  //
                 GetFlagArgVal("cuda_graph", arg, &FLAG_cudaGraph) ||        //
+                GetFlagArgVal("check_allocs", arg, &FLAG_checkAllocs) ||    //
                 GetFlagArgVal("log", arg, &FLAG_log) ||                     //
                 GetFlagArgVal("log_level", arg, &FLAG_logLevel))) {
       continue;
@@ -302,6 +312,7 @@ struct FXApp {
     errFlag = +2,
     errRead = +3,
     errWrite = +4,
+    errAlloc = +5,
     errNone = NVCV_SUCCESS,  // Video Effects SDK errors
     errGeneral = NVCV_ERR_GENERAL,
     errUnimplemented = NVCV_ERR_UNIMPLEMENTED,
@@ -353,6 +364,9 @@ struct FXApp {
     _maxInputHeight = 2160u;
     _maxNumberStreams = 1u;
     _batchOfStates = nullptr;
+    _allocCounter = nullptr;
+    _frameGraphs = false;
+    _graphStrength = -1.f;
   }
   ~FXApp() { destroyEffect(); }
 
@@ -363,6 +377,10 @@ struct FXApp {
   NvCV_Status allocTempBuffers();
   Err processImage(const char* inFile, const char* outFile);
   Err processMovie(const char* inFile, const char* outFile);
+  NvCV_Status runFrame(const NvCVImage* src, const NvCVImage& matteY, NvCVImage* result);
+  NvCV_Status compositeFrame(const NvCVImage& matteY, NvCVImage* result);
+  NvCV_Status runFrameGraph(const NvCVImage& matteY);
+  NvCV_Status releaseFrameGraphs();
   Err processKey(int key);
   void nextCompMode();
   void drawFrameRate(cv::Mat& img);
@@ -390,12 +408,22 @@ struct FXApp {
   NvCVImage _srcNvVFXImage;
   NvCVImage _dstNvVFXImage;
   NvCVImage _blurNvVFXImage;
+  NvCVImage _bgNvVFXImage;    // The background of compBG, uploaded once
+  NvCVImage _halfNvVFXImage;  // A constant matte of 1/2, with which compLight blends the matte over the input
+  NvCVImage _compNvVFXImage;  // The composite, which is the only image downloaded per frame
   float _blurStrength;
   unsigned int _maxInputWidth;
   unsigned int _maxInputHeight;
   unsigned int _maxNumberStreams;
   std::vector<NvVFX_StateObjectHandle> _stateArray;
   NvVFX_StateObjectHandle* _batchOfStates;
+  AllocCounter* _allocCounter;  // If set, a video must not allocate any cv::Mat after its first frame
+
+  bool _frameGraphs;                 // Each frame of a video is replayed from the graph for its composition mode
+  FrameGraph _graphs[compBlur + 1];  // The whole of a frame, captured for each composition mode when it is first used
+  NvCVImage _stageSrc;               // The pinned source frame, which the frame graphs upload
+  NvCVImage _stageDst;               // The pinned composite, which the frame graphs download
+  float _graphStrength;              // The blur strength that the compBlur graph was captured with
 };
 
 const char* FXApp::errorStringFromCode(Err code) {
@@ -408,6 +436,7 @@ const char* FXApp::errorStringFromCode(Err code) {
       {errWrite, "There was a problem writing a file"},
       {errQuit, "The user chose to quit the application"},
       {errFlag, "There was a problem with the command-line arguments"},
+      {errAlloc, "Memory was allocated after the first frame"},
   };
   if ((int)code <= 0) return NvCV_GetErrorStringFromCode((NvCV_Status)code);
   for (const LutEntry* p = lut; p != &lut[sizeof(lut) / sizeof(lut[0])]; ++p)
@@ -526,7 +555,9 @@ NvCV_Status FXApp::createAigsEffect() {
     return vfxErr;
   }
 
-  vfxErr = NvVFX_SetU32(_eff, NVVFX_CUDA_GRAPH, FLAG_cudaGraph ? 1u : 0u);
+  // Whole frames of a video are captured in graphs if they can be (see runFrameGraph()), which needs the effect to
+  // launch its own kernels; it is loaded again with a graph of its own if they cannot.
+  vfxErr = NvVFX_SetU32(_eff, NVVFX_CUDA_GRAPH, (FLAG_cudaGraph && !FrameGraph::Supported()) ? 1u : 0u);
   if (vfxErr != NVCV_SUCCESS) {
     std::cerr << "Error enabling cuda graph \n";
     return vfxErr;
@@ -619,10 +650,10 @@ void FXApp::destroyEffect() {
   }
 }
 
-static void overlay(const cv::Mat& image, const cv::Mat& mask, float alpha, cv::Mat& result) {
-  cv::Mat maskClr;
+// maskClr is scratch; like the result, it is only allocated if it is not already the size of the image.
+static void overlay(const cv::Mat& image, const cv::Mat& mask, float alpha, cv::Mat& maskClr, cv::Mat& result) {
   cv::cvtColor(mask, maskClr, cv::COLOR_GRAY2BGR);
-  result = image * (1.f - alpha) + maskClr * alpha;
+  cv::addWeighted(image, 1.f - alpha, maskClr, alpha, 0., result);
 }
 
 static NvCV_Status WriteRGBA(const NvCVImage* bgr, const NvCVImage* a, const std::string& name) {
@@ -642,7 +673,7 @@ static NvCV_Status WriteRGBA(const NvCVImage* bgr, const NvCVImage* a, const std
 FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
   NvCV_Status vfxErr;
   bool ok;
-  cv::Mat result;
+  cv::Mat result, maskClr;
   NvCVImage fxSrcChunkyGPU, fxDstChunkyGPU;
 
   // Allocate space for batchOfStates to hold state variable addresses
@@ -687,9 +718,9 @@ FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
   BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
   BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&fxDstChunkyGPU, &_dstVFX, 1.0f, _stream, NULL));
 
-  overlay(_srcImg, _dstImg, 0.5, result);
+  overlay(_srcImg, _dstImg, 0.5, maskClr, result);
   if (!std::string(outFile).empty()) {
-    if (IsLossyImageFile(outFile)) fprintf(stderr, "WARNING: JPEG output file format will reduce image quality\n");
+    if (IsLossyImageFile(outFile)) APP_LOG_WARNING("JPEG output file format will reduce image quality\n");
     vfxErr = WriteRGBA(&_srcVFX, &_dstVFX, outFile);
     if (NVCV_SUCCESS != vfxErr) {
       printf("%s: \"%s\"\n", NvCV_GetErrorStringFromCode(vfxErr), outFile);
@@ -717,14 +748,20 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   NvCV_Status vfxErr = NVCV_SUCCESS;
   bool ok;
   cv::Mat result;
+  NvCVImage bgVFX, resultVFX, matteY;
   cv::VideoCapture reader;
+  LatestFrameReader frameReader;  // This must be closed before the reader is released
   cv::VideoWriter writer;
   unsigned frameNum;
   VideoInfo info;
   unsigned int modelBatch = 1;
+  unsigned long long allocs = 0;
+  unsigned steadyFrame;
+  cv::Mat stage;
 
   if (inFile && !inFile[0]) inFile = nullptr;  // Set file paths to NULL if zero length
   if (outFile && !outFile[0]) outFile = nullptr;
+  steadyFrame = inFile ? 1 : 3;  // The webcam's capture thread shapes its 3 rotating frames over the first few
 
   if (inFile) {
     reader.open(inFile);
@@ -812,107 +849,100 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   if (!_blurNvVFXImage.pixels)
     BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_blurNvVFXImage, width, height, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 1));
 
-  for (frameNum = 0; reader.read(_srcImg); ++frameNum) {
-    if (_srcImg.empty()) printf("Frame %u is empty\n", frameNum);
+  // allocate the background, the blend matte and the composite for GPU
+  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_bgNvVFXImage, width, height, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 1));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_halfNvVFXImage, width, height, NVCV_A, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 1));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_compNvVFXImage, width, height, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 1));
+  if (FLAG_cudaGraph && FrameGraph::Supported()) {  // The frame graphs upload from and download to pinned buffers
+    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_stageSrc, width, height, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_CPU_PINNED,
+                                         0));
+    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_stageDst, width, height, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_CPU_PINNED,
+                                         0));
+    _frameGraphs = true;
+  }
+  NvCVImage_InitView(&matteY, &_dstNvVFXImage, 0, 0, width, height);
+  matteY.pixelFormat = NVCV_Y;  // So that it is expanded to gray, rather than used as alpha, when shown as compMatte
 
-    _dstImg = cv::Mat::zeros(_srcImg.size(),
-                             CV_8UC1);  // TODO: Allocate and clear outside of the loop?
-    BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
+  // Everything that the loop uses is allocated, bound and loaded here, so the loop itself does none of it.
+  _dstImg.create(height, width, CV_8UC1);
+  BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
+  (void)NVWrapperForCVMat(&_dstImg, &_dstVFX);
+  result = cv::Mat::zeros(height, width, CV_8UC3);
+  BAIL_IF_NULL(result.data, vfxErr, NVCV_ERR_MEMORY);
+  (void)NVWrapperForCVMat(&result, &resultVFX);
+  {
+    cv::Mat half(height, width, CV_8UC1, cv::Scalar(128));
+    NvCVImage halfVFX;
+    (void)NVWrapperForCVMat(&half, &halfVFX);
+    halfVFX.pixelFormat = NVCV_A;
+    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&halfVFX, &_halfNvVFXImage, 1.0f, _stream, NULL));
+  }
 
-    (void)NVWrapperForCVMat(&_srcImg, &_srcVFX);  // Ditto
-    (void)NVWrapperForCVMat(&_dstImg, &_dstVFX);
+  if (FLAG_bgFile.empty()) {
+    _resizedCroppedBgImg = cv::Mat(height, width, CV_8UC3, cv::Scalar(118, 185, 0));
+    size_t startX = _resizedCroppedBgImg.cols / 20;
+    size_t offsetY = _resizedCroppedBgImg.rows / 20;
+    std::string text = "No Background Image!";
+    for (size_t startY = offsetY; startY < _resizedCroppedBgImg.rows; startY += offsetY) {
+      cv::putText(_resizedCroppedBgImg, text, cv::Point(startX, startY), cv::FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(0, 0, 0),
+                  1);
+    }
+  }
+  (void)NVWrapperForCVMat(&_resizedCroppedBgImg, &bgVFX);
+  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&bgVFX, &_bgNvVFXImage, 1.0f, _stream, NULL));
 
-    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcNvVFXImage));
-    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstNvVFXImage));
-    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcNvVFXImage, 1.0f, _stream, NULL));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcNvVFXImage));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstNvVFXImage));
 
-    // Assign states from stateArray in batchOfStates
-    // There is only one stream in this app
-    _batchOfStates[0] = _stateArray[0];
-    BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(_eff, NVVFX_STATE, _batchOfStates));
+  // Assign states from stateArray in batchOfStates
+  // There is only one stream in this app
+  _batchOfStates[0] = _stateArray[0];
+  BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(_eff, NVVFX_STATE, _batchOfStates));
 
-    auto startTime = std::chrono::high_resolution_clock::now();
-    BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
-    auto endTime = std::chrono::high_resolution_clock::now();
-    ms = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+  // The blur is loaded whatever the initial mode, as it can be chosen with a key at any frame
+  BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_bgblurEff, NVVFX_STRENGTH, _blurStrength));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_bgblurEff, NVVFX_INPUT_IMAGE_0, &_srcNvVFXImage));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_bgblurEff, NVVFX_INPUT_IMAGE_1, &_dstNvVFXImage));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_bgblurEff, NVVFX_OUTPUT_IMAGE, &_blurNvVFXImage));
+  BAIL_IF_ERR(vfxErr = NvVFX_Load(_bgblurEff));
+
+  // A webcam is captured on its own thread, and only its newest frame is processed, so latency cannot build up when
+  // processing is slower than capture.
+  frameReader.open(&reader, !inFile);
+  for (frameNum = 0; frameReader.read(_srcImg); ++frameNum) {
+    if (_srcImg.empty()) APP_LOG_WARNING("Frame %u is empty\n", frameNum);
+
+    if (_frameGraphs) {  // The run cannot be timed apart from the rest of the graph, so the whole frame is timed
+      CVWrapperForNvCVImage(&_stageSrc, &stage);
+      _srcImg.copyTo(stage);
+      auto startTime = std::chrono::high_resolution_clock::now();
+      BAIL_IF_ERR(vfxErr = runFrameGraph(matteY));
+      auto endTime = std::chrono::high_resolution_clock::now();
+      ms = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+      CVWrapperForNvCVImage(&_stageDst, &stage);
+      if (compNone != _compMode) stage.copyTo(result);
+    } else {
+      (void)NVWrapperForCVMat(&_srcImg, &_srcVFX);  // A webcam frame may be in a different buffer each time
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcNvVFXImage, 1.0f, _stream, NULL));
+
+      auto startTime = std::chrono::high_resolution_clock::now();
+      BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
+      auto endTime = std::chrono::high_resolution_clock::now();
+      ms = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+      BAIL_IF_ERR(vfxErr = compositeFrame(matteY, &resultVFX));
+    }
+    if (compNone == _compMode) _srcImg.copyTo(result);
     _count += 1;
     if (_count > 0) {
       // skipping first frame
       _total += ms;
     }
-
-    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstNvVFXImage, &_dstVFX, 1.0f, _stream, NULL));
-
-    result.create(_srcImg.rows, _srcImg.cols,
-                  CV_8UC3);  // Make sure the result is allocated. TODO: allocate
-                             // outsifde of the loop?
-    BAIL_IF_NULL(result.data, vfxErr, NVCV_ERR_MEMORY);
-    result.setTo(cv::Scalar::all(0));  // TODO: This may no longer be necessary
-                                       // since we no longer coerce to 16:9
-    switch (_compMode) {
-      case compNone:
-        _srcImg.copyTo(result);
-        break;
-      case compBG: {
-        if (FLAG_bgFile.empty()) {
-          _resizedCroppedBgImg = cv::Mat(_srcImg.rows, _srcImg.cols, CV_8UC3, cv::Scalar(118, 185, 0));
-          size_t startX = _resizedCroppedBgImg.cols / 20;
-          size_t offsetY = _resizedCroppedBgImg.rows / 20;
-          std::string text = "No Background Image!";
-          for (size_t startY = offsetY; startY < _resizedCroppedBgImg.rows; startY += offsetY) {
-            cv::putText(_resizedCroppedBgImg, text, cv::Point(startX, startY), cv::FONT_HERSHEY_DUPLEX, 1.0,
-                        CV_RGB(0, 0, 0), 1);
-          }
-        }
-        NvCVImage bgVFX;
-        (void)NVWrapperForCVMat(&_resizedCroppedBgImg, &bgVFX);
-        NvCVImage matVFX;
-        (void)NVWrapperForCVMat(&result, &matVFX);
-        NvCVImage_Composite(&_srcVFX, &bgVFX, &_dstVFX, &matVFX, _stream);
-      } break;
-      case compLight:
-        if (inFile) {
-          overlay(_srcImg, _dstImg, 0.5, result);
-        } else {  // If the webcam was cropped, also crop the compositing
-          cv::Rect rect(0, (_srcImg.rows - _srcVFX.height) / 2, _srcVFX.width, _srcVFX.height);
-          cv::Mat subResult = result(rect);
-          overlay(_srcImg(rect), _dstImg(rect), 0.5, subResult);
-        }
-        break;
-      case compGreen: {
-        const unsigned char bgColor[3] = {0, 255, 0};
-        NvCVImage matVFX;
-        (void)NVWrapperForCVMat(&result, &matVFX);
-        NvCVImage_CompositeOverConstant(&_srcVFX, &_dstVFX, bgColor, &matVFX, _stream);
-      } break;
-      case compWhite: {
-        const unsigned char bgColor[3] = {255, 255, 255};
-        NvCVImage matVFX;
-        (void)NVWrapperForCVMat(&result, &matVFX);
-        NvCVImage_CompositeOverConstant(&_srcVFX, &_dstVFX, bgColor, &matVFX, _stream);
-      } break;
-      case compMatte:
-        cv::cvtColor(_dstImg, result, cv::COLOR_GRAY2BGR);
-        break;
-      case compBlur:
-        BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_bgblurEff, NVVFX_STRENGTH, _blurStrength));
-        BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_bgblurEff, NVVFX_INPUT_IMAGE_0, &_srcNvVFXImage));
-        BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_bgblurEff, NVVFX_INPUT_IMAGE_1, &_dstNvVFXImage));
-        BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_bgblurEff, NVVFX_OUTPUT_IMAGE, &_blurNvVFXImage));
-        BAIL_IF_ERR(vfxErr = NvVFX_Load(_bgblurEff));
-        BAIL_IF_ERR(vfxErr = NvVFX_Run(_bgblurEff, 0));
-
-        NvCVImage matVFX;
-        (void)NVWrapperForCVMat(&result, &matVFX);
-        BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_blurNvVFXImage, &matVFX, 1.0f, _stream, NULL));
-
-        break;
-    }
     if (outFile) {
 #define WRITE_COMPOSITE
 #ifdef WRITE_COMPOSITE
       writer.write(result);
 #else   // WRITE_MATTE
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstNvVFXImage, &_dstVFX, 1.0f, _stream, NULL));
       writer.write(_dstImg);
 #endif  // WRITE_MATTE
     }
@@ -930,17 +960,135 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
         fprintf(stderr, "\b\b\b\b???%%");
       else
         fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+    if (_allocCounter && frameNum + 1 == steadyFrame) allocs = _allocCounter->count();
   }
 
   if (_progress) fprintf(stderr, "\n");
+  if (_allocCounter && frameNum > steadyFrame) {  // Everything that went through cv::Mat, including reading and writing
+    allocs = _allocCounter->count() - allocs;
+    printf("%llu cv::Mat allocations after frame %u\n", allocs, steadyFrame - 1);
+    if (allocs) appErr = errAlloc;
+  }
+  frameReader.close();
+  if (!inFile) APP_LOG_INFO("%u of %u captured frames were dropped\n", frameReader.dropped(), frameReader.captured());
   reader.release();
   if (outFile) writer.release();
 bail:
   // Dealloc
+  for (FrameGraph& graph : _graphs) graph.reset();  // They replay the images below
+  _frameGraphs = false;
+  NvCVImage_Dealloc(&(_stageSrc));
+  NvCVImage_Dealloc(&(_stageDst));
   NvCVImage_Dealloc(&(_srcNvVFXImage));  // This is also called in the destructor, ...
   NvCVImage_Dealloc(&(_dstNvVFXImage));  // ... so is not necessary except in C code.
   NvCVImage_Dealloc(&(_blurNvVFXImage));
-  return appErrFromVfxStatus(vfxErr);
+  NvCVImage_Dealloc(&(_bgNvVFXImage));
+  NvCVImage_Dealloc(&(_halfNvVFXImage));
+  NvCVImage_Dealloc(&(_compNvVFXImage));
+  return (NVCV_SUCCESS != vfxErr) ? appErrFromVfxStatus(vfxErr) : appErr;
+}
+
+// Composite the matte on the GPU according to _compMode, and download the composite into result. Every mode composites
+// from the input and matte that are already there, so only the composite is downloaded; compNone shows the input,
+// which is still on the CPU, so nothing is downloaded for it.
+NvCV_Status FXApp::compositeFrame(const NvCVImage& matteY, NvCVImage* result) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  const NvCVImage* comp = &_compNvVFXImage;
+
+  switch (_compMode) {
+    case compNone:
+      comp = nullptr;
+      break;
+    case compBG:
+      BAIL_IF_ERR(vfxErr = NvCVImage_Composite(&_srcNvVFXImage, &_bgNvVFXImage, &_dstNvVFXImage, &_compNvVFXImage,
+                                               _stream));
+      break;
+    case compLight:  // The blur's output is free in this mode, so it holds the matte, expanded to BGR
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&matteY, &_blurNvVFXImage, 1.0f, _stream, NULL));
+      BAIL_IF_ERR(vfxErr = NvCVImage_Composite(&_blurNvVFXImage, &_srcNvVFXImage, &_halfNvVFXImage, &_compNvVFXImage,
+                                               _stream));
+      break;
+    case compGreen: {  // The color is static, so that it outlives the capture of a frame graph
+      static const unsigned char bgColor[3] = {0, 255, 0};
+      BAIL_IF_ERR(vfxErr = NvCVImage_CompositeOverConstant(&_srcNvVFXImage, &_dstNvVFXImage, bgColor,
+                                                           &_compNvVFXImage, _stream));
+    } break;
+    case compWhite: {
+      static const unsigned char bgColor[3] = {255, 255, 255};
+      BAIL_IF_ERR(vfxErr = NvCVImage_CompositeOverConstant(&_srcNvVFXImage, &_dstNvVFXImage, bgColor,
+                                                           &_compNvVFXImage, _stream));
+    } break;
+    case compMatte:
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&matteY, &_compNvVFXImage, 1.0f, _stream, NULL));
+      break;
+    case compBlur:  // The strength is changed with a key, which does not need the effect to be loaded again
+      BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_bgblurEff, NVVFX_STRENGTH, _blurStrength));
+      BAIL_IF_ERR(vfxErr = NvVFX_Run(_bgblurEff, 0));
+      comp = &_blurNvVFXImage;
+      break;
+  }
+  if (comp) BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(comp, result, 1.0f, _stream, NULL));
+bail:
+  return vfxErr;
+}
+
+// src --> _srcNvVFXImage --> matte --> composite --> result, all queued on _stream. This is the work of one frame, as
+// it is captured in a frame graph.
+NvCV_Status FXApp::runFrame(const NvCVImage* src, const NvCVImage& matteY, NvCVImage* result) {
+  NvCV_Status vfxErr;
+  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(src, &_srcNvVFXImage, 1.0f, _stream, NULL));
+  BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
+  BAIL_IF_ERR(vfxErr = compositeFrame(matteY, result));
+bail:
+  return vfxErr;
+}
+
+// _stageSrc --> ... --> _stageDst, replayed from the graph for the composition mode, and waited for. A mode's graph is
+// captured at the first frame that uses it, which is run step by step to bind and shape everything that the graph
+// will replay. The blur is captured again whenever its strength changes, since its graph holds the strength that it
+// was captured with. If a frame cannot be captured, the app goes back to running frames step by step.
+NvCV_Status FXApp::runFrameGraph(const NvCVImage& matteY) {
+  NvCV_Status vfxErr;
+  FrameGraph& graph = _graphs[_compMode];
+  FrameGraph::Sequence sequence = [this, &matteY]() { return runFrame(&_stageSrc, matteY, &_stageDst); };
+
+  if (compBlur == _compMode && _graphStrength != _blurStrength) graph.reset();
+  if (graph.captured()) {
+    BAIL_IF_ERR(vfxErr = graph.launch(_stream));
+    return FrameGraph::Synchronize(_stream);
+  }
+  BAIL_IF_ERR(vfxErr = sequence());
+  BAIL_IF_ERR(vfxErr = FrameGraph::Synchronize(_stream));  // This frame is done, whether or not it can be captured
+  vfxErr = graph.capture(_stream, sequence);
+  if (NVCV_SUCCESS != vfxErr) {
+    APP_LOG_WARNING("%s frames could not be captured in CUDA graphs: %s\n", _effectName,
+                    NvCV_GetErrorStringFromCode(vfxErr));
+    BAIL_IF_ERR(vfxErr = releaseFrameGraphs());
+  } else if (compBlur == _compMode) {
+    _graphStrength = _blurStrength;
+  }
+bail:
+  return vfxErr;
+}
+
+// Go back to running each frame step by step, with the effect replaying its own kernels from a CUDA graph, as it is
+// loaded without frame graphs. That needs it to be loaded again, and its states to be allocated again.
+NvCV_Status FXApp::releaseFrameGraphs() {
+  NvCV_Status vfxErr;
+  _frameGraphs = false;
+  for (FrameGraph& graph : _graphs) graph.reset();
+  for (NvVFX_StateObjectHandle state : _stateArray) NvVFX_DeallocateState(_eff, state);
+  _stateArray.clear();
+  BAIL_IF_ERR(vfxErr = CudaGraphLoader::Load(_eff, _effectName, true, nullptr));
+  for (unsigned int i = 0; i < _maxNumberStreams; i++) {
+    NvVFX_StateObjectHandle state = nullptr;
+    BAIL_IF_ERR(vfxErr = NvVFX_AllocateState(_eff, &state));
+    _stateArray.push_back(state);
+  }
+  _batchOfStates[0] = _stateArray[0];
+  BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(_eff, NVVFX_STATE, _batchOfStates));
+bail:
+  return vfxErr;
 }
 
 // This path is used by nvVideoEffectsProxy.cpp to load the SDK dll
@@ -975,9 +1123,13 @@ int main(int argc, char** argv) {
   NvCV_Status err = NvVFX_ConfigureLogger(FLAG_logLevel, FLAG_log.c_str(), nullptr, nullptr);
   if (NVCV_SUCCESS != err)
     printf("%s: while configuring logger to \"%s\"\n", NvCV_GetErrorStringFromCode(err), FLAG_log.c_str());
+  static StderrLogger appLogger;  // App diagnostics, as opposed to SDK diagnostics
+  AppLogSetSink(StderrLogger::Callback, &appLogger);
+  if (FLAG_verbose) AppLogSetLevel(APP_LOG_LEVEL_INFO);
 
   FXApp::Err fxErr = FXApp::errNone;
   FXApp app;
+  AllocCounter allocCounter;  // Destroyed before the app, which frees its own cv::Mat normally
 
   if (FLAG_inFile.empty() && !FLAG_webcam) {
     std::cerr << "Please specify --in_file=XXX or --webcam\n";
@@ -990,6 +1142,10 @@ int main(int argc, char** argv) {
 
   app._progress = FLAG_progress;
   app.setShow(FLAG_show);
+  if (FLAG_checkAllocs) {
+    allocCounter.install();
+    app._allocCounter = &allocCounter;
+  }
 
   app._compMode = static_cast<FXApp::CompMode>(FLAG_compMode);
   if (!isCompModeEnumValid(app._compMode)) {
@@ -28,11 +28,20 @@
 #include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "appLog.h"
+#include "cudaGraphLoader.h"
+#include "latestFrameReader.h"
+#include "nvCVLoggerExamples.h"
 #include "nvCVOpenCV.h"
 #include "nvVFXDenoising.h"
 #include "nvVideoEffects.h"
 #include "opencv2/opencv.hpp"
+#include "segmentJoiner.h"
+#include "statePool.h"
+#include "staticFrameDetector.h"
 
 #ifdef _MSC_VER
 #define strcasecmp _stricmp
@@ -62,11 +71,12 @@
 #define DEFAULT_CODEC "H264"
 #endif  // _WIN32
 
-bool FLAG_debug = false, FLAG_verbose = false, FLAG_show = false, FLAG_progress = false, FLAG_webcam = false;
-int FLAG_logLevel = NVCV_LOG_ERROR;
-float FLAG_strength = 0.f;
+bool FLAG_debug = false, FLAG_verbose = false, FLAG_show = false, FLAG_progress = false, FLAG_webcam = false,
+     FLAG_cudaGraph = false, FLAG_skipStatic = false;
+int FLAG_logLevel = NVCV_LOG_ERROR, FLAG_statePool = 1, FLAG_segments = 1, FLAG_warmup = 30;
+float FLAG_strength = 0.f, FLAG_staticThreshold = .5f;
 std::string FLAG_codec = DEFAULT_CODEC, FLAG_camRes = "1280x720", FLAG_inFile, FLAG_outFile, FLAG_outDir, FLAG_modelDir,
-            FLAG_log = "stderr";
+            FLAG_log = "stderr", FLAG_clipList;
 
 // Set this when using OTA Updates
 // This path is used by nvVideoEffectsProxy.cpp to load the SDK dll
@@ -134,6 +144,11 @@ static void Usage() {
       "observed on videos)\n"
       "  --webcam                   use a webcam as the input\n"
       "  --out_file=<path>          output file to be written\n"
+      "  --clip_list=<file>         a file naming clips for one loaded effect to denoise in turn, one path per line\n"
+      "  --out_dir=<path>           the directory to write the denoised clips to, under their own names\n"
+      "  --state_pool=<N>           the number of state objects allocated up front, for clips to lease (default 1)\n"
+      "  --segments=<N>             denoise a video as N segments in parallel, by N effect instances (default 1)\n"
+      "  --warmup=<N>               the frames before a segment that are denoised to converge its state (default 30)\n"
       "  --show                     display the results in a window (for webcam, it is always true)\n"
       "  --cam_res=[WWWx]HHH        specify resolution as height or width x height\n"
       "  --strength=<value>         strength of an effect [0-1]\n"
@@ -141,6 +156,10 @@ static void Usage() {
       "  --codec=<fourcc>           the fourcc code for the desired codec (default " DEFAULT_CODEC
       ")\n"
       "  --progress                 show progress\n"
+      "  --cuda_graph               replay the effect's kernels from a CUDA graph, to reduce the launch overhead\n"
+      "  --skip_static              reuse the last output for a frame that repeats the last frame denoised\n"
+      "  --static_threshold=<N>     the largest mean difference, in 8-bit levels, of any 32x32 tile of a repeated\n"
+      "                             frame (default 0.5)\n"
       "  --verbose                  verbose output\n"
       "  --debug                    print extra debugging information\n"
       "  --log=<file>               log SDK errors to a file, \"stderr\" or \"\" (default stderr)\n"
@@ -155,21 +174,29 @@ static int ParseMyArgs(int argc, char** argv) {
     const char* arg = *argv;
     if (arg[0] != '-') {
       continue;
-    } else if ((arg[1] == '-') &&                                   //
-               (GetFlagArgVal("verbose", arg, &FLAG_verbose) ||     //
-                GetFlagArgVal("in", arg, &FLAG_inFile) ||           //
-                GetFlagArgVal("in_file", arg, &FLAG_inFile) ||      //
-                GetFlagArgVal("out", arg, &FLAG_outFile) ||         //
-                GetFlagArgVal("out_file", arg, &FLAG_outFile) ||    //
-                GetFlagArgVal("show", arg, &FLAG_show) ||           //
-                GetFlagArgVal("webcam", arg, &FLAG_webcam) ||       //
-                GetFlagArgVal("cam_res", arg, &FLAG_camRes) ||      //
-                GetFlagArgVal("strength", arg, &FLAG_strength) ||   //
-                GetFlagArgVal("model_dir", arg, &FLAG_modelDir) ||  //
-                GetFlagArgVal("codec", arg, &FLAG_codec) ||         //
-                GetFlagArgVal("progress", arg, &FLAG_progress) ||   //
-                GetFlagArgVal("log", arg, &FLAG_log) ||             //
-                GetFlagArgVal("log_level", arg, &FLAG_logLevel) ||  //
+    } else if ((arg[1] == '-') &&                                                 //
+               (GetFlagArgVal("verbose", arg, &FLAG_verbose) ||                   //
+                GetFlagArgVal("in", arg, &FLAG_inFile) ||                         //
+                GetFlagArgVal("in_file", arg, &FLAG_inFile) ||                    //
+                GetFlagArgVal("out", arg, &FLAG_outFile) ||                       //
+                GetFlagArgVal("out_file", arg, &FLAG_outFile) ||                  //
+                GetFlagArgVal("clip_list", arg, &FLAG_clipList) ||                //
+                GetFlagArgVal("out_dir", arg, &FLAG_outDir) ||                    //
+                GetFlagArgVal("state_pool", arg, &FLAG_statePool) ||              //
+                GetFlagArgVal("segments", arg, &FLAG_segments) ||                 //
+                GetFlagArgVal("warmup", arg, &FLAG_warmup) ||                     //
+                GetFlagArgVal("show", arg, &FLAG_show) ||                         //
+                GetFlagArgVal("webcam", arg, &FLAG_webcam) ||                     //
+                GetFlagArgVal("cam_res", arg, &FLAG_camRes) ||                    //
+                GetFlagArgVal("strength", arg, &FLAG_strength) ||                 //
+                GetFlagArgVal("model_dir", arg, &FLAG_modelDir) ||                //
+                GetFlagArgVal("codec", arg, &FLAG_codec) ||                       //
+                GetFlagArgVal("progress", arg, &FLAG_progress) ||                 //
+                GetFlagArgVal("cuda_graph", arg, &FLAG_cudaGraph) ||              //
+                GetFlagArgVal("skip_static", arg, &FLAG_skipStatic) ||            //
+                GetFlagArgVal("static_threshold", arg, &FLAG_staticThreshold) ||  //
+                GetFlagArgVal("log", arg, &FLAG_log) ||                           //
+                GetFlagArgVal("log_level", arg, &FLAG_logLevel) ||                //
                 GetFlagArgVal("debug", arg, &FLAG_debug))) {
       continue;
     } else if (GetFlagArgVal("help", arg, &help)) {
@@ -217,6 +244,27 @@ static bool IsImageFile(const char* str) {
 
 static bool IsLossyImageFile(const char* str) { return HasOneOfTheseSuffixes(str, ".jpg", ".jpeg", nullptr); }
 
+// Read the paths of the clips to be denoised, one per line, skipping blank lines and comments that start with '#'.
+static bool ReadClipList(const char* file, std::vector<std::string>* clips) {
+  char line[1024];
+  FILE* fd = fopen(file, "r");
+  if (!fd) return false;
+  while (fgets(line, sizeof(line), fd)) {
+    size_t len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    if (len && '#' != line[0]) clips->push_back(line);
+  }
+  fclose(fd);
+  return true;
+}
+
+// A clip from the list is written to --out_dir, under its own name, or not at all.
+static std::string ClipOutFile(const std::string& clip) {
+  if (FLAG_outDir.empty()) return std::string();
+  size_t slash = clip.find_last_of("/\\");
+  return FLAG_outDir + '/' + clip.substr((std::string::npos == slash) ? 0 : slash + 1);
+}
+
 static const char* DurationString(double sc) {
   static char buf[16];
   int hr, mn;
@@ -305,22 +353,38 @@ struct FXApp {
 
   FXApp() {
     _eff = nullptr;
+    _stream = nullptr;
     _effectName = nullptr;
     _inited = false;
+    _quit = false;
+    _staticFrames = nullptr;
+    _cudaGraph = false;
+    _boundBuf = -1;
+    _poolSize = 1;
+    _clipWidth = 0;
+    _clipHeight = 0;
     _showFPS = false;
     _progress = false;
     _show = false;
     _enableEffect = true, _drawVisualization = true, _framePeriod = 0.f;
   }
-  ~FXApp() { NvVFX_DestroyEffect(_eff); }
+  ~FXApp() { destroyEffect(); }
 
   void setShow(bool show) { _show = show; }
   Err createEffect(const char* effectSelector, const char* modelDir);
   void destroyEffect();
   NvCV_Status allocBuffers(unsigned width, unsigned height);
   NvCV_Status allocTempBuffers();
+  NvCV_Status prepareClip(unsigned width, unsigned height);
   Err processImage(const char* inFile, const char* outFile);
   Err processMovie(const char* inFile, const char* outFile);
+  Err processMovieSegmented(const char* inFile, const char* outFile, unsigned numSegments, unsigned warmup);
+  Err processSegment(const char* inFile, SegmentJoiner* joiner, unsigned k, long long firstFrame, long long numFrames,
+                     unsigned warmup);
+  NvCV_Status loadEffect();
+  NvCV_Status runFrame(unsigned buf, NvVFX_StateObjectHandle state);
+  unsigned frameBuf(unsigned frameNum) const { return _cudaGraph ? 0 : (frameNum & 1); }
+  Err outputFrame(cv::VideoWriter* writer, unsigned frameNum, const VideoInfo& info);
   Err initCamera(cv::VideoCapture& cap);
   Err processKey(int key);
   void drawFrameRate(cv::Mat& img);
@@ -329,15 +393,24 @@ struct FXApp {
   const char* errorStringFromCode(Err code);
 
   NvVFX_Handle _eff;
+  CUstream _stream;
   cv::Mat _srcImg;
   cv::Mat _dstImg;
-  NvCVImage _srcGpuBuf;
-  NvCVImage _dstGpuBuf;
+  NvCVImage _srcGpuBuf[2];  // Double-buffered, so that frame k+1 can be uploaded while frame k is being denoised
+  NvCVImage _dstGpuBuf[2];
   NvCVImage _srcVFX;
   NvCVImage _dstVFX;
-  NvCVImage _tmpVFX;  // We use the same temporary buffer for source and dst, since it auto-shapes as needed
+  NvCVImage _tmpVFX;     // We use the same temporary buffer for source and dst, since it auto-shapes as needed
+  bool _cudaGraph;       // The effect replays a CUDA graph, captured for one set of buffers
+  int _boundBuf;         // The buffer set bound to the effect, or -1 if none
+  StatePool _statePool;  // The denoiser's state objects, one leased by each clip
+  unsigned _poolSize;    // The number of states allocated when the effect is loaded
+  unsigned _clipWidth;   // The size of the clips that the effect is loaded for
+  unsigned _clipHeight;
   bool _show;
   bool _inited;
+  bool _quit;                          // The user chose to quit, so no more clips are processed
+  StaticFrameDetector* _staticFrames;  // NULL unless frames that repeat the last one denoised are skipped
   bool _showFPS;
   bool _progress;
   bool _enableEffect;
@@ -403,6 +476,7 @@ FXApp::Err FXApp::processKey(int key) {
     case 'e':
     case 'E':
       _enableEffect = !_enableEffect;
+      if (_staticFrames) _staticFrames->reset();  // The last output no longer matches the effect
       break;
     case 'd':
     case 'D':
@@ -458,13 +532,22 @@ FXApp::Err FXApp::createEffect(const char* effectSelector, const char* modelDir)
   if (modelDir[0] != '\0') {
     BAIL_IF_ERR(vfxErr = NvVFX_SetString(_eff, NVVFX_MODEL_DIRECTORY, modelDir));
   }
+  BAIL_IF_ERR(vfxErr = NvVFX_CudaStreamCreate(&_stream));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(_eff, NVVFX_CUDA_STREAM, _stream));
 bail:
   return appErrFromVfxStatus(vfxErr);
 }
 
 void FXApp::destroyEffect() {
-  NvVFX_DestroyEffect(_eff);
-  _eff = nullptr;
+  _statePool.destroy();  // The states belong to the effect
+  if (_eff) {
+    NvVFX_DestroyEffect(_eff);
+    _eff = nullptr;
+  }
+  if (_stream) {
+    NvVFX_CudaStreamDestroy(_stream);
+    _stream = nullptr;
+  }
 }
 
 // Allocate one temp buffer to be used for input and output. Reshaping of the temp buffer in NvCVImage_Transfer() is
@@ -474,8 +557,8 @@ void FXApp::destroyEffect() {
 // memory at load time.
 NvCV_Status FXApp::allocTempBuffers() {
   NvCV_Status vfxErr;
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_tmpVFX, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat,
-                                       _dstVFX.componentType, _dstVFX.planar, NVCV_GPU, 0));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_tmpVFX, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat,
+                                         _dstVFX.componentType, _dstVFX.planar, NVCV_GPU, 0));
   BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_tmpVFX, _srcVFX.width, _srcVFX.height, _srcVFX.pixelFormat,
                                          _srcVFX.componentType, _srcVFX.planar, NVCV_GPU, 0));
 bail:
@@ -487,10 +570,8 @@ NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
 
   if (_inited) return NVCV_SUCCESS;
 
-  if (!_srcImg.data) {
-    _srcImg.create(height, width, CV_8UC3);  // src CPU
-    BAIL_IF_NULL(_srcImg.data, vfxErr, NVCV_ERR_MEMORY);
-  }
+  _srcImg.create(height, width, CV_8UC3);  // src CPU; this keeps an image that has been read, which has this size
+  BAIL_IF_NULL(_srcImg.data, vfxErr, NVCV_ERR_MEMORY);
 
   _dstImg.create(_srcImg.rows, _srcImg.cols, _srcImg.type());  // 
   BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);         // 
@@ -498,10 +579,12 @@ NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
   NVWrapperForCVMat(&_srcImg, &_srcVFX);  // _srcVFX is an alias for _srcImg
   NVWrapperForCVMat(&_dstImg, &_dstVFX);  // _dstVFX is an alias for _dstImg
 
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_srcGpuBuf, _srcVFX.width, _srcVFX.height, _srcVFX.pixelFormat, NVCV_F32,
-                                       NVCV_PLANAR, NVCV_GPU, 1));  // src GPU
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_dstGpuBuf, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat, NVCV_F32,
-                                       NVCV_PLANAR, NVCV_GPU, 1));  // dst GPU
+  for (NvCVImage& buf : _srcGpuBuf)  // Realloc, to reshape the buffers of an earlier clip of another size
+    BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _srcVFX.width, _srcVFX.height, _srcVFX.pixelFormat, NVCV_F32,
+                                         NVCV_PLANAR, NVCV_GPU, 1));  // src GPU
+  for (NvCVImage& buf : _dstGpuBuf)
+    BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat, NVCV_F32,
+                                         NVCV_PLANAR, NVCV_GPU, 1));  // dst GPU
 
 // #define ALLOC_TEMP_BUFFERS_AT_RUN_TIME    // Deferring temp buffer allocation is easier
 #ifndef ALLOC_TEMP_BUFFERS_AT_RUN_TIME       // Allocating temp buffers at load time avoids run time hiccups
@@ -515,8 +598,29 @@ bail:
   return vfxErr;
 }
 
+// Allocate the buffers, load the effect and allocate the state pool for clips of the given size, unless this has
+// already been done for an earlier clip of the same size. Each clip then only leases a state, and gives it back.
+NvCV_Status FXApp::prepareClip(unsigned width, unsigned height) {
+  NvCV_Status vfxErr;
+
+  if (_inited && width == _clipWidth && height == _clipHeight) return NVCV_SUCCESS;
+  _statePool.destroy();  // The states were allocated for the effect as it was loaded
+  _inited = false;
+  BAIL_IF_ERR(vfxErr = allocBuffers(width, height));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf[0]));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf[0]));
+  _boundBuf = 0;
+  BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_eff, NVVFX_STRENGTH, FLAG_strength));
+  BAIL_IF_ERR(vfxErr = loadEffect());
+  BAIL_IF_ERR(vfxErr = _statePool.init(_eff, _poolSize));
+  _clipWidth = width;
+  _clipHeight = height;
+bail:
+  if (NVCV_SUCCESS != vfxErr) _inited = false;  // Try again for the next clip
+  return vfxErr;
+}
+
 FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
-  CUstream stream = 0;
   NvCV_Status vfxErr;
 
   NvVFX_StateObjectHandle state = nullptr;
@@ -525,21 +629,18 @@ FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
   _srcImg = cv::imread(inFile);
   if (!_srcImg.data) return errRead;
 
-  BAIL_IF_ERR(vfxErr = allocBuffers(_srcImg.cols, _srcImg.rows));
-  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf, 1.f, stream, &_tmpVFX));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_eff, NVVFX_STRENGTH, FLAG_strength));
+  BAIL_IF_ERR(vfxErr = prepareClip(_srcImg.cols, _srcImg.rows));
+  NVWrapperForCVMat(&_srcImg, &_srcVFX);
+  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf[0], 1.f, _stream, &_tmpVFX));
 
-  BAIL_IF_ERR(NvVFX_AllocateState(_eff, &state));
+  BAIL_IF_ERR(vfxErr = _statePool.lease(&state));
   BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(_eff, NVVFX_STATE, &state));
 
-  BAIL_IF_ERR(vfxErr = NvVFX_Load(_eff));
-  BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
-  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf, &_dstVFX, 1.f, stream, &_tmpVFX));
+  BAIL_IF_ERR(vfxErr = runFrame(0, state));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf[0], &_dstVFX, 1.f, _stream, &_tmpVFX));
 
   if (outFile && outFile[0]) {
-    if (IsLossyImageFile(outFile)) fprintf(stderr, "WARNING: JPEG output file format will reduce image quality\n");
+    if (IsLossyImageFile(outFile)) APP_LOG_WARNING("JPEG output file format will reduce image quality\n");
     if (!cv::imwrite(outFile, _dstImg)) {
       printf("Error writing: \"%s\"\n", outFile);
       return errWrite;
@@ -550,19 +651,20 @@ FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
     cv::waitKey(3000);
   }
 bail:
-  if (state) NvVFX_DeallocateState(_eff, state);  // release state memory
+  if (state) _statePool.giveBack(state);  // reset for the next clip
   return appErrFromVfxStatus(vfxErr);
 }
 
 FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   const int fourcc_h264 = cv::VideoWriter::fourcc('H', '2', '6', '4');
-  CUstream stream = 0;
   FXApp::Err appErr = errNone;
   bool ok;
   cv::VideoCapture reader;
+  LatestFrameReader frameReader;  // This must be closed before the reader is released
   cv::VideoWriter writer;
   NvCV_Status vfxErr;
-  unsigned frameNum;
+  unsigned frameNum, buf;
+  bool same;  // Frame k repeats the last frame denoised
   VideoInfo info;
 
   NvVFX_StateObjectHandle state = nullptr;
@@ -587,9 +689,9 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   GetVideoInfo(reader, (inFile ? inFile : "webcam"), &info);
   if (!(fourcc_h264 == info.codec ||
         cv::VideoWriter::fourcc('a', 'v', 'c', '1') == info.codec))  // avc1 is alias for h264
-    printf("Filters only target H264 videos, not %.4s\n", (char*)&info.codec);
+    APP_LOG_WARNING("Filters only target H264 videos, not %.4s\n", (char*)&info.codec);
 
-  BAIL_IF_ERR(vfxErr = allocBuffers(info.width, info.height));
+  BAIL_IF_ERR(vfxErr = prepareClip(info.width, info.height));
 
   if (outFile && !outFile[0]) outFile = nullptr;
   if (outFile) {
@@ -601,52 +703,197 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
     }
   }
 
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_eff, NVVFX_STRENGTH, FLAG_strength));
-
-  BAIL_IF_ERR(NvVFX_AllocateState(_eff, &state));
+  BAIL_IF_ERR(vfxErr = _statePool.lease(&state));
   BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(_eff, NVVFX_STATE, &state));
 
-  BAIL_IF_ERR(vfxErr = NvVFX_Load(_eff));
-
-  for (frameNum = 0; reader.read(_srcImg); frameNum++) {
-    if (_enableEffect) {
-      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf, 1.f / 255.f, stream, &_tmpVFX));
-      BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
-      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf, &_dstVFX, 255.f, stream, &_tmpVFX));
-    } else {
-      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_dstVFX, 1.f, stream, &_tmpVFX));
-      NvVFX_ResetState(_eff, state);  // reset state
+  // Frame k is uploaded and denoised on the GPU while frame k-1 is downloaded, encoded and displayed, so the two frames
+  // alternate between two sets of GPU buffers, or share one with a CUDA graph (see CudaGraphLoader). Work is queued on
+  // _stream in frame order, so the temporal state sees the frames in order. A webcam is captured on its own thread, and
+  // only its newest frame is denoised, so latency cannot build up when denoising is slower than capture. A frame that
+  // repeats the last frame denoised is neither uploaded nor denoised: the state does not see it, and the output of
+  // frame k-1 is copied on the GPU, in stream order, so the state stays that of the frame whose output is reused.
+  if (_staticFrames) _staticFrames->reset();  // Frames of an earlier clip are not repeated
+  frameReader.open(&reader, FLAG_webcam);
+  for (frameNum = 0; frameReader.read(_srcImg); frameNum++) {
+    buf = frameBuf(frameNum);
+    same = _enableEffect && _staticFrames && _staticFrames->isRepeat(_srcImg);
+    if (!same) {
+      NVWrapperForCVMat(&_srcImg, &_srcVFX);  // The reader recycles its frame buffers
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf[buf], 1.f / 255.f, _stream, &_tmpVFX));
     }
-
-    if (outFile) writer.write(_dstImg);
-
-    if (_show) {
-      if (_drawVisualization) drawEffectStatus(_dstImg);
-      drawFrameRate(_dstImg);
-      cv::imshow("Output", _dstImg);
-      int key = cv::waitKey(1);
-      if (key > 0) {
-        appErr = processKey(key);
-        if (errQuit == appErr) break;
-      }
+    if (frameNum)  // frame k-1; a download into pageable memory waits for the copy to complete
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf[frameBuf(frameNum - 1)], &_dstVFX, 255.f, _stream, &_tmpVFX));
+    if (!same) {
+      BAIL_IF_ERR(vfxErr = runFrame(buf, state));  // asynchronous
+      if (_staticFrames && _enableEffect) _staticFrames->keep(_srcImg);
+    } else if (frameBuf(frameNum - 1) != buf) {  // Repeat the output of frame k-1
+      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf[frameBuf(frameNum - 1)], &_dstGpuBuf[buf], 1.f, _stream,
+                                              nullptr));
     }
-    if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+    if (frameNum && errQuit == (appErr = outputFrame((outFile ? &writer : nullptr), frameNum - 1, info))) break;
+  }
+  if (frameNum && errQuit != appErr) {  // Flush the last frame
+    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf[frameBuf(frameNum - 1)], &_dstVFX, 255.f, _stream, &_tmpVFX));
+    outputFrame((outFile ? &writer : nullptr), frameNum - 1, info);
   }
 
   if (_progress) fprintf(stderr, "\n");
+  if (errQuit == appErr) _quit = true;
+  frameReader.close();
+  if (FLAG_webcam)
+    APP_LOG_INFO("%u of %u captured frames were dropped\n", frameReader.dropped(), frameReader.captured());
   reader.release();
   if (outFile) writer.release();
 bail:
-  if (state) NvVFX_DeallocateState(_eff, state);  // release state memory
+  if (state) _statePool.giveBack(state);  // reset for the next clip
   return appErrFromVfxStatus(vfxErr);
 }
 
+// Split a video file into numSegments time segments, and denoise each on its own thread, with its own instance of the
+// effect and its own CUDA stream; this instance takes the first segment. The denoiser is temporal, so a segment that
+// started cold would not match the end of the segment before it; instead, each segment first denoises the warmup
+// frames before its start and discards them, so that its state has converged by its first frame. The SegmentJoiner
+// hands the frames to this thread in order, to be encoded once.
+FXApp::Err FXApp::processMovieSegmented(const char* inFile, const char* outFile, unsigned numSegments,
+                                        unsigned warmup) {
+  std::vector<FXApp*> apps(numSegments, nullptr);
+  std::vector<Err> errs(numSegments, errNone);
+  SegmentJoiner joiner;
+  cv::VideoCapture reader;
+  cv::VideoWriter writer;
+  VideoInfo info;
+  Err appErr = errNone;
+
+  reader.open(inFile);
+  if (!reader.isOpened()) {
+    printf("Error: Could not open video: \"%s\"\n", inFile);
+    return errRead;
+  }
+  GetVideoInfo(reader, inFile, &info);
+  reader.release();
+  if (info.frameCount < (long long)numSegments) {
+    printf("Error: \"%s\" has too few frames to split into %u segments\n", inFile, numSegments);
+    return errRead;
+  }
+
+  apps[0] = this;
+  for (unsigned k = 1; k < numSegments && errNone == appErr; ++k) {
+    apps[k] = new FXApp;
+    appErr = apps[k]->createEffect(_effectName, FLAG_modelDir.c_str());
+  }
+  if (errNone == appErr) {
+    bool ok = joiner.run(
+        outFile, info.frameCount, cv::Size(info.width, info.height), numSegments,
+        [&](unsigned k, long long first, long long count) {
+          errs[k] = apps[k]->processSegment(inFile, &joiner, k, first, count, warmup);
+          return errNone == errs[k];
+        },
+        [&](const cv::Mat& frame) {
+          if (!writer.isOpened() &&
+              !writer.open(outFile, StringToFourcc(FLAG_codec), info.frameRate, cv::Size(info.width, info.height))) {
+            printf("Cannot open \"%s\" for video writing\n", outFile);
+            appErr = errWrite;
+            return false;
+          }
+          writer.write(frame);
+          return true;
+        });
+    for (unsigned k = 0; k < numSegments && errNone == appErr; ++k) appErr = errs[k];
+    if (!ok && errNone == appErr) appErr = errRead;  // A segment gave too few frames
+  }
+  for (unsigned k = 1; k < numSegments; ++k) delete apps[k];
+  writer.release();
+  return appErr;
+}
+
+// Denoise frames [firstFrame, firstFrame + numFrames) of a video file, as segment k of the joiner. Up to warmup frames
+// before firstFrame are denoised first, only to converge the state, and are not joined.
+FXApp::Err FXApp::processSegment(const char* inFile, SegmentJoiner* joiner, unsigned k, long long firstFrame,
+                                 long long numFrames, unsigned warmup) {
+  cv::VideoCapture reader;
+  Err appErr = errNone;
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  NvVFX_StateObjectHandle state = nullptr;
+  long long startFrame = (firstFrame > (long long)warmup) ? firstFrame - warmup : 0, n;
+
+  reader.open(inFile);
+  if (!reader.isOpened()) return errRead;
+  if (startFrame && (!reader.set(cv::CAP_PROP_POS_FRAMES, (double)startFrame) ||
+                     (long long)reader.get(cv::CAP_PROP_POS_FRAMES) != startFrame)) {
+    printf("Error: Could not seek to frame %lld of \"%s\"\n", startFrame, inFile);
+    return errRead;
+  }
+  BAIL_IF_ERR(vfxErr = prepareClip((unsigned)reader.get(cv::CAP_PROP_FRAME_WIDTH),
+                                   (unsigned)reader.get(cv::CAP_PROP_FRAME_HEIGHT)));
+  BAIL_IF_ERR(vfxErr = _statePool.lease(&state));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(_eff, NVVFX_STATE, &state));
+  for (n = startFrame - firstFrame; n < numFrames && reader.read(_srcImg); ++n) {
+    NVWrapperForCVMat(&_srcImg, &_srcVFX);
+    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf[0], 1.f / 255.f, _stream, &_tmpVFX));
+    BAIL_IF_ERR(vfxErr = runFrame(0, state));
+    if (n < 0) continue;  // A warm-up frame
+    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf[0], &_dstVFX, 255.f, _stream, &_tmpVFX));
+    if (!joiner->put(k, _dstImg)) {  // The join has failed
+      appErr = errWrite;
+      goto bail;
+    }
+  }
+  APP_LOG_INFO("Frames %lld to %lld denoised, after %lld warm-up frames\n", firstFrame, firstFrame + n - 1,
+               firstFrame - startFrame);
+  if (n < numFrames) {
+    printf("Error: \"%s\" ended %lld frames before the end of segment %u\n", inFile, numFrames - n, k);
+    appErr = errRead;
+  }
+bail:
+  if (state) _statePool.giveBack(state);
+  return (NVCV_SUCCESS != vfxErr) ? appErrFromVfxStatus(vfxErr) : appErr;
+}
+
+// Load the effect, replaying its kernels from a CUDA graph if requested and supported.
+NvCV_Status FXApp::loadEffect() {
+  return CudaGraphLoader::Load(_eff, _effectName, FLAG_cudaGraph, &_cudaGraph);
+}
+
+// _srcGpuBuf[buf] --> _dstGpuBuf[buf]
+// The images are bound whenever the buffer set changes; they alternate from frame to frame, unless the effect replays
+// a CUDA graph. The work is queued on _stream, and the result is not waited for here.
+NvCV_Status FXApp::runFrame(unsigned buf, NvVFX_StateObjectHandle state) {
+  NvCV_Status vfxErr;
+  if (!_enableEffect) {
+    NvVFX_ResetState(_eff, state);  // reset state
+    return NvCVImage_Transfer(&_srcGpuBuf[buf], &_dstGpuBuf[buf], 1.f, _stream, &_tmpVFX);
+  }
+  if (_boundBuf != (int)buf) {
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf[buf]));
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf[buf]));
+    _boundBuf = (int)buf;
+  }
+  BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
+bail:
+  return vfxErr;
+}
+
+// Write, display and report progress for _dstImg.
+// Returns errQuit if the user chose to quit.
+FXApp::Err FXApp::outputFrame(cv::VideoWriter* writer, unsigned frameNum, const VideoInfo& info) {
+  Err appErr = errNone;
+  if (writer) writer->write(_dstImg);
+  if (_show) {
+    if (_drawVisualization) drawEffectStatus(_dstImg);
+    drawFrameRate(_dstImg);
+    cv::imshow("Output", _dstImg);
+    int key = cv::waitKey(1);
+    if (key > 0) appErr = processKey(key);
+  }
+  if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+  return appErr;
+}
+
 int main(int argc, char** argv) {
   FXApp::Err fxErr = FXApp::errNone;
   int nErrs;
   FXApp app;
+  StaticFrameDetector staticFrames;
 
   nErrs = ParseMyArgs(argc, argv);
   if (nErrs) std::cerr << nErrs << " command line syntax problems\n";
@@ -656,22 +903,53 @@ int main(int argc, char** argv) {
     if (NVCV_SUCCESS != vfxErr)
       printf("%s: while configuring logger to \"%s\"\n", NvCV_GetErrorStringFromCode(vfxErr), FLAG_log.c_str());
   }
+  static StderrLogger appLogger;  // App diagnostics, as opposed to SDK diagnostics
+  AppLogSetSink(StderrLogger::Callback, &appLogger);
+  if (FLAG_debug)
+    AppLogSetLevel(APP_LOG_LEVEL_DEBUG);
+  else if (FLAG_verbose)
+    AppLogSetLevel(APP_LOG_LEVEL_INFO);
 
   if (FLAG_webcam) {
     // If webcam is on, enable showing the results and turn off displaying the progress
     if (FLAG_progress) FLAG_progress = !FLAG_progress;
     if (!FLAG_show) FLAG_show = !FLAG_show;
   }
-  if (FLAG_inFile.empty() && !FLAG_webcam) {
-    std::cerr << "Please specify --in_file=XXX or --webcam=true\n";
+  if (FLAG_inFile.empty() && FLAG_clipList.empty() && !FLAG_webcam) {
+    std::cerr << "Please specify --in_file=XXX, --clip_list=XXX or --webcam=true\n";
+    ++nErrs;
+  }
+  if (FLAG_outFile.empty() && FLAG_outDir.empty() && !FLAG_show) {
+    std::cerr << "Please specify --out_file=XXX, --out_dir=XXX or --show\n";
+    ++nErrs;
+  }
+  if (FLAG_skipStatic && FLAG_segments > 1) {
+    std::cerr << "--skip_static cannot be combined with --segments\n";
+    ++nErrs;
+  }
+  if (FLAG_segments > 1 && (FLAG_webcam || FLAG_show || (FLAG_outFile.empty() && FLAG_outDir.empty()))) {
+    std::cerr << "--segments requires video files and --out_file=XXX or --out_dir=XXX; it cannot be combined with "
+                 "--webcam or --show\n";
     ++nErrs;
   }
-  if (FLAG_outFile.empty() && !FLAG_show) {
-    std::cerr << "Please specify --out_file=XXX or --show\n";
+  if (FLAG_statePool < 1 || FLAG_warmup < 0) {
+    std::cerr << "--state_pool must be at least 1, and --warmup at least 0\n";
+    ++nErrs;
+  }
+  std::vector<std::string> clips;
+  if (FLAG_clipList.empty()) {
+    clips.push_back(FLAG_inFile);
+  } else if (!ReadClipList(FLAG_clipList.c_str(), &clips)) {
+    std::cerr << "Cannot read the clip list \"" << FLAG_clipList << "\"\n";
     ++nErrs;
   }
   app._progress = FLAG_progress;
+  app._poolSize = (unsigned)FLAG_statePool;
   app.setShow(FLAG_show);
+  if (FLAG_skipStatic) {
+    staticFrames.setThreshold(FLAG_staticThreshold);
+    app._staticFrames = &staticFrames;
+  }
 
   if (nErrs) {
     Usage();
@@ -681,10 +959,25 @@ int main(int argc, char** argv) {
     if (FXApp::errNone != fxErr) {
       std::cerr << "Error creating effect\n";
     } else {
-      if (IsImageFile(FLAG_inFile.c_str()))
-        fxErr = app.processImage(FLAG_inFile.c_str(), FLAG_outFile.c_str());
-      else
-        fxErr = app.processMovie(FLAG_inFile.c_str(), FLAG_outFile.c_str());
+      // The effect is loaded once, and each clip leases a state from its pool, rather than allocating one
+      for (const std::string& clip : clips) {
+        std::string outFile = FLAG_clipList.empty() ? FLAG_outFile : ClipOutFile(clip);
+        FXApp::Err clipErr;
+        if (IsImageFile(clip.c_str()))
+          clipErr = app.processImage(clip.c_str(), outFile.c_str());
+        else if (FLAG_segments > 1)
+          clipErr = app.processMovieSegmented(clip.c_str(), outFile.c_str(), FLAG_segments, FLAG_warmup);
+        else
+          clipErr = app.processMovie(clip.c_str(), outFile.c_str());
+        if (FXApp::errNone != clipErr) {
+          if (!FLAG_clipList.empty())
+            std::cerr << "Error: " << app.errorStringFromCode(clipErr) << " in \"" << clip << "\"\n";
+          if (FXApp::errNone == fxErr) fxErr = clipErr;
+        }
+        if (app._quit) break;
+      }
+      if (FLAG_verbose || !FLAG_clipList.empty()) app._statePool.report(stdout);
+      if (FLAG_skipStatic) staticFrames.report(stdout);
     }
   }
 
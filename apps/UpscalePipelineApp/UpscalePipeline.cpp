@@ -28,14 +28,27 @@
 #include <chrono>
 #include <iostream>
 #include <string>
+#include <vector>
 
+#include "appLog.h"
+#include "cascadePlanner.h"
+#include "effectChain.h"
+#include "nvCVLoggerExamples.h"
 #include "nvCVOpenCV.h"
+#ifdef HAVE_NVVFX_DENOISING
+#include "nvVFXDenoising.h"
+#endif  // HAVE_NVVFX_DENOISING
+#ifdef HAVE_NVVFX_SUPER_RES
+#include "nvVFXSuperRes.h"
+#endif  // HAVE_NVVFX_SUPER_RES
 #include "nvVFXUpscale.h"
 #include "nvVideoEffects.h"
 #include "opencv2/opencv.hpp"
+#include "yuvWriter.h"
 
 /*########################################################################################################################
 # This application demonstrates the Upscaler feature, to produce an upscaled version of the image/image sequence.
+# With --chain, it runs several effects in turn on the GPU, e.g. Denoise --> SuperRes --> Upscale.
 ##########################################################################################################################*/
 
 #ifdef _MSC_VER
@@ -66,10 +79,12 @@
 #define DEFAULT_CODEC "H264"
 #endif  // _WIN32
 
-bool FLAG_debug = false, FLAG_verbose = false, FLAG_show = false, FLAG_progress = false;
-int FLAG_resolution = 0, FLAG_arMode = 0, FLAG_logLevel = NVCV_LOG_ERROR;
-float FLAG_upscaleStrength = 0.2f;
-std::string FLAG_codec = DEFAULT_CODEC, FLAG_inFile, FLAG_outFile, FLAG_outDir, FLAG_modelDir, FLAG_log = "stderr";
+bool FLAG_debug = false, FLAG_verbose = false, FLAG_show = false, FLAG_progress = false, FLAG_cudaGraph = false,
+     FLAG_f16 = false;
+int FLAG_resolution = 0, FLAG_arMode = 0, FLAG_logLevel = NVCV_LOG_ERROR, FLAG_superResMode = 0;
+float FLAG_upscaleStrength = 0.2f, FLAG_denoiseStrength = 0.f;
+std::string FLAG_codec = DEFAULT_CODEC, FLAG_inFile, FLAG_outFile, FLAG_outDir, FLAG_modelDir, FLAG_log = "stderr",
+            FLAG_chain, FLAG_quality, FLAG_costTable = "UpscalePipelineCosts.txt";
 
 // Set this when using OTA Updates
 // This path is used by nvVideoEffectsProxy.cpp to load the SDK dll
@@ -134,7 +149,8 @@ static void Usage() {
       "UpscalePipelineApp [args ...]\n"
       "  where args is:\n"
       "  --in_file=<path>                    input file to be processed\n"
-      "  --out_file=<path>                   output file to be written\n"
+      "  --out_file=<path>                   output file to be written; a video ending in .y4m, .yuv or .nv12 is\n"
+      "                                      written as raw 4:2:0 YUV, for an external encoder\n"
       "  --show                              display the results in a window\n"
       "  --upscale_strength=(0 to 1)         strength of upscale filter (float value between 0 to 1)\n"
       "  --resolution=<height>               the desired height of the output\n"
@@ -143,6 +159,20 @@ static void Usage() {
       "  --codec=<fourcc>                    the fourcc code for the desired codec (default " DEFAULT_CODEC
       ")\n"
       "  --progress                          show progress\n"
+      "  --cuda_graph                        replay the effect's kernels from a CUDA graph, to reduce launch overhead\n"
+      "  --chain=<effects>                   the effects to apply in turn, e.g.\n"
+      "                                      \"Denoise,SuperRes:1440,Upscale:2160\"; a scaling effect scales to its\n"
+      "                                      given height, or to --resolution\n"
+      "                                      (default \"Upscale\")\n"
+      "  --denoise_strength=<0|1>            the strength of the Denoise effect in a chain (default 0)\n"
+      "  --superres_mode=<0|1>               the mode of the SuperRes effect in a chain: 0 - conservative,\n"
+      "                                      1 - aggressive (default 0)\n"
+      "  --quality=<fast|balanced|best>      instead of --chain, choose the cheapest cascade of SuperRes and Upscale\n"
+      "                                      to --resolution that meets this quality tier\n"
+      "  --f16                               give F16 images to the chained effects that take F32, where they accept\n"
+      "                                      them, halving the memory and bandwidth of the buffers between them\n"
+      "  --cost_table=<file>                 the file in which the measured cost of each cascade stage is cached\n"
+      "                                      (default \"UpscalePipelineCosts.txt\")\n"
       "  --verbose                           verbose output\n"
       "  --debug                             print extra debugging information\n"
       "  --log=<file>                        log SDK errors to a file, \"stderr\" or \"\" (default stderr)\n"
@@ -170,6 +200,13 @@ static int ParseMyArgs(int argc, char** argv) {
                 GetFlagArgVal("model_dir", arg, &FLAG_modelDir) ||                //
                 GetFlagArgVal("codec", arg, &FLAG_codec) ||                       //
                 GetFlagArgVal("progress", arg, &FLAG_progress) ||                 //
+                GetFlagArgVal("cuda_graph", arg, &FLAG_cudaGraph) ||              //
+                GetFlagArgVal("chain", arg, &FLAG_chain) ||                       //
+                GetFlagArgVal("denoise_strength", arg, &FLAG_denoiseStrength) ||  //
+                GetFlagArgVal("superres_mode", arg, &FLAG_superResMode) ||        //
+                GetFlagArgVal("quality", arg, &FLAG_quality) ||                   //
+                GetFlagArgVal("cost_table", arg, &FLAG_costTable) ||              //
+                GetFlagArgVal("f16", arg, &FLAG_f16) ||                           //
                 GetFlagArgVal("debug", arg, &FLAG_debug) ||                       //
                 GetFlagArgVal("log", arg, &FLAG_log) ||                           //
                 GetFlagArgVal("log_level", arg, &FLAG_logLevel))) {
@@ -267,6 +304,103 @@ static int StringToFourcc(const std::string& str) {
   return x.i;
 }
 
+// The effects that can be chained, and the format of the images that each takes. Denoise and SuperRes are available
+// only if their features were found when the app was built.
+enum Scaling {
+  noScaling,     // The output is the size of the input
+  fixedScaling,  // The output is 4/3, 1.5, 2, 3 or 4 times the size of the input
+  anyScaling,    // The output is up to 4 times the size of the input
+};
+struct ChainEffect {
+  const char* name;               // The name used in --chain
+  NvVFX_EffectSelector selector;  // The effect
+  EffectChain::Format format;     // The format of its input and output
+  Scaling scaling;                // The heights to which it can scale its input
+  bool highQuality;               // Its scaling counts towards the --quality tier
+  bool stateful;                  // It keeps temporal state
+  bool hasModel;                  // It accepts NVVFX_MODEL_DIRECTORY
+};
+static const ChainEffect chainEffects[] = {
+#ifdef HAVE_NVVFX_DENOISING
+    {"Denoise", NVVFX_FX_DENOISING, {NVCV_BGR, NVCV_F32, NVCV_PLANAR, 1}, noScaling, false, true, true},
+#endif  // HAVE_NVVFX_DENOISING
+#ifdef HAVE_NVVFX_SUPER_RES
+    {"SuperRes", NVVFX_FX_SUPER_RES, {NVCV_BGR, NVCV_F32, NVCV_PLANAR, 1}, fixedScaling, true, false, true},
+#endif  // HAVE_NVVFX_SUPER_RES
+    {"Upscale", NVVFX_FX_SR_UPSCALE, {NVCV_RGBA, NVCV_U8, NVCV_INTERLEAVED, 32}, anyScaling, false, false, false},
+};
+
+static const ChainEffect* FindChainEffect(const char* name) {
+  for (const ChainEffect& e : chainEffects)
+    if (!strcasecmp(e.name, name)) return &e;
+  return nullptr;
+}
+
+// Set the parameters of an effect in a chain from the command line.
+static NvCV_Status SetChainParams(const ChainEffect& fx, NvVFX_Handle eff) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  if (fx.hasModel && !FLAG_modelDir.empty())
+    BAIL_IF_ERR(vfxErr = NvVFX_SetString(eff, NVVFX_MODEL_DIRECTORY, FLAG_modelDir.c_str()));
+  if (!strcmp(fx.name, "Upscale"))
+    BAIL_IF_ERR(vfxErr = NvVFX_SetF32(eff, NVVFX_STRENGTH, FLAG_upscaleStrength));
+  else if (!strcmp(fx.name, "SuperRes"))
+    BAIL_IF_ERR(vfxErr = NvVFX_SetU32(eff, NVVFX_MODE, (unsigned)FLAG_superResMode));
+  else if (!strcmp(fx.name, "Denoise"))
+    BAIL_IF_ERR(vfxErr = NvVFX_SetF32(eff, NVVFX_STRENGTH, FLAG_denoiseStrength));
+bail:
+  return vfxErr;
+}
+
+// The settings of an effect in a chain that change the time that it takes, as keyed in --cost_table: the precision of
+// its images, whether it replays a CUDA graph, and the parameters set by SetChainParams().
+static std::string CostSettings(const ChainEffect& fx) {
+  const char* precision = (NVCV_F32 != fx.format.componentType) ? "u8" : (FLAG_f16 ? "f16" : "f32");
+  const char* graph = FLAG_cudaGraph ? "graph" : "nograph";
+  char buf[64];
+  if (!strcmp(fx.name, "Upscale"))
+    snprintf(buf, sizeof(buf), "%s,%s,strength=%g", precision, graph, FLAG_upscaleStrength);
+  else if (!strcmp(fx.name, "SuperRes"))
+    snprintf(buf, sizeof(buf), "%s,%s,mode=%d", precision, graph, FLAG_superResMode);
+  else if (!strcmp(fx.name, "Denoise"))
+    snprintf(buf, sizeof(buf), "%s,%s,strength=%g", precision, graph, FLAG_denoiseStrength);
+  else
+    snprintf(buf, sizeof(buf), "%s,%s", precision, graph);
+  return buf;
+}
+
+struct ChainStep {
+  const ChainEffect* effect;
+  unsigned height;  // The height to which it scales, or 0
+};
+
+// Parse a comma-separated list of effects, each of which may be followed by ":height" if it scales. A scaling effect
+// without a height scales to --resolution.
+static bool ParseChain(const std::string& str, std::vector<ChainStep>* steps) {
+  steps->clear();
+  for (size_t pos = 0; pos < str.size();) {
+    size_t end = str.find(',', pos), colon;
+    if (end == std::string::npos) end = str.size();
+    std::string item = str.substr(pos, end - pos), name = item.substr(0, (colon = item.find(':')));
+    ChainStep step = {FindChainEffect(name.c_str()), 0};
+    if (!step.effect) {
+      printf("Unknown or unavailable effect in --chain: \"%s\"\n", name.c_str());
+      return false;
+    }
+    if (colon != std::string::npos) step.height = (unsigned)strtoul(item.c_str() + colon + 1, nullptr, 10);
+    if (noScaling == step.effect->scaling && step.height) {
+      printf("%s does not scale, so it cannot be given a height\n", step.effect->name);
+      return false;
+    }
+    if (noScaling != step.effect->scaling && !step.height && !(step.height = (unsigned)FLAG_resolution)) {
+      printf("%s needs a height in --chain, or --resolution\n", step.effect->name);
+      return false;
+    }
+    steps->push_back(step);
+    pos = end + 1;
+  }
+  return !steps->empty();
+}
+
 struct FXApp {
   enum Err {
     errQuit = +1,  // Application errors
@@ -306,8 +440,8 @@ struct FXApp {
   };
 
   FXApp() {
-    _upscaleEff = nullptr;
     _inited = false;
+    _yuvOnGpu = true;
     _showFPS = false;
     _progress = false;
     _show = false;
@@ -316,25 +450,27 @@ struct FXApp {
   ~FXApp() { destroyEffects(); }
 
   void setShow(bool show) { _show = show; }
-  Err createEffects(NvVFX_EffectSelector eff);
+  Err createEffects(const std::vector<ChainStep>& steps);
   void destroyEffects();
   NvCV_Status allocBuffers(unsigned width, unsigned height);
-  NvCV_Status allocTempBuffers();
   Err processImage(const char* inFile, const char* outFile);
   Err processMovie(const char* inFile, const char* outFile);
+  unsigned frameBuf(unsigned frameNum) const { return _chain.doubleBuffered() ? (frameNum & 1) : 0; }
+  NvCV_Status downloadFrame(unsigned buf);
+  Err outputFrame(cv::VideoWriter* writer, unsigned frameNum, const VideoInfo& info);
   Err processKey(int key);
   void drawFrameRate(cv::Mat& img);
   Err appErrFromVfxStatus(NvCV_Status status) { return (Err)status; }
   const char* errorStringFromCode(Err code);
 
-  NvVFX_Handle _upscaleEff;
+  EffectChain _chain;  // The effects, which run in turn on one stream, with their GPU buffers
   cv::Mat _srcImg;
   cv::Mat _dstImg;
-  NvCVImage _interGpuRGBAu8;
-  NvCVImage _dstGpuBuf;
   NvCVImage _srcVFX;
   NvCVImage _dstVFX;
-  NvCVImage _tmpVFX;
+  NvCVImage _dstYUV;       // The output, as it is written to a YUV file
+  YUVWriter _yuvWriter;    // The YUV file, if the output is written as YUV rather than encoded by OpenCV
+  bool _yuvOnGpu;          // The output is converted to YUV as it is downloaded, rather than on the CPU
   bool _show;
   bool _inited;
   bool _showFPS;
@@ -403,36 +539,23 @@ FXApp::Err FXApp::processKey(int key) {
   return errNone;
 }
 
-FXApp::Err FXApp::createEffects(NvVFX_EffectSelector eff) {
-  NvCV_Status vfxErr;
-  BAIL_IF_ERR(vfxErr = NvVFX_CreateEffect(eff, &_upscaleEff));
+// Create the effects of the chain, in order, and set their parameters.
+FXApp::Err FXApp::createEffects(const std::vector<ChainStep>& steps) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  for (const ChainStep& step : steps) {
+    BAIL_IF_ERR(vfxErr = _chain.addStage(step.effect->selector, step.effect->format, step.height,
+                                         step.effect->stateful));
+    BAIL_IF_ERR(vfxErr = SetChainParams(*step.effect, _chain.effect(_chain.numStages() - 1)));
+  }
 bail:
   return appErrFromVfxStatus(vfxErr);
 }
 
-void FXApp::destroyEffects() {
-  NvVFX_DestroyEffect(_upscaleEff);
-  _upscaleEff = nullptr;
-}
-
-// Allocate one temp buffer to be used for input and output. Reshaping of the temp buffer in NvCVImage_Transfer() is
-// done automatically, and is very low overhead. We expect the destination to be largest, so we allocate that first to
-// minimize reallocs probablistically. Then we Realloc for the source to get the union of the two. This could
-// alternately be done at runtime by feeding in an empty temp NvCVImage, but there are advantages to allocating all
-// memory at load time.
-NvCV_Status FXApp::allocTempBuffers() {
-  NvCV_Status vfxErr;
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_tmpVFX, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat,
-                                       _dstVFX.componentType, _dstVFX.planar, NVCV_GPU, 0));
-  BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_tmpVFX, _srcVFX.width, _srcVFX.height, _srcVFX.pixelFormat,
-                                         _srcVFX.componentType, _srcVFX.planar, NVCV_GPU, 0));
-bail:
-  return vfxErr;
-}
+void FXApp::destroyEffects() { _chain.destroy(); }
 
+// The GPU buffers belong to the chain, which negotiates them between its effects and loads the effects.
 NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
   NvCV_Status vfxErr = NVCV_SUCCESS;
-  int dstWidth;
 
   if (_inited) return NVCV_SUCCESS;
 
@@ -440,29 +563,12 @@ NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
     _srcImg.create(height, width, CV_8UC3);  // src CPU
     BAIL_IF_NULL(_srcImg.data, vfxErr, NVCV_ERR_MEMORY);
   }
-
-  if (!FLAG_resolution) {
-    printf("--resolution has not been specified\n");
-    return NVCV_ERR_PARAMETER;
-  }
-  dstWidth = _srcImg.cols * FLAG_resolution / _srcImg.rows;
-  _dstImg.create(FLAG_resolution, dstWidth, _srcImg.type());  // dst CPU
+  BAIL_IF_ERR(vfxErr = _chain.load(_srcImg.cols, _srcImg.rows, FLAG_cudaGraph, FLAG_f16));
+  APP_LOG_INFO("%s\n", _chain.plan().c_str());
+  _dstImg.create(_chain.outputHeight(), _chain.outputWidth(), _srcImg.type());  // dst CPU
   BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
-
-  BAIL_IF_ERR(vfxErr = NvVFX_SetF32(_upscaleEff, NVVFX_STRENGTH, FLAG_upscaleStrength));
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_interGpuRGBAu8, _srcImg.cols, _srcImg.rows, NVCV_RGBA, NVCV_U8,
-                                       NVCV_INTERLEAVED, NVCV_GPU, 32));  // intermediate GPU
-
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_dstGpuBuf, _dstImg.cols, _dstImg.rows, NVCV_RGBA, NVCV_U8, NVCV_INTERLEAVED,
-                                       NVCV_GPU, 32));  // dst GPU
-  NVWrapperForCVMat(&_srcImg, &_srcVFX);                // _srcVFX is an alias for _srcImg
-  NVWrapperForCVMat(&_dstImg, &_dstVFX);                // _dstVFX is an alias for _dstImg
-
-// #define ALLOC_TEMP_BUFFERS_AT_RUN_TIME    // Deferring temp buffer allocation is easier
-#ifndef ALLOC_TEMP_BUFFERS_AT_RUN_TIME       // Allocating temp buffers at load time avoids run time hiccups
-  BAIL_IF_ERR(vfxErr = allocTempBuffers());  // This uses _srcVFX and _dstVFX and allocates one buffer to be a temporary
-                                             // for src and dst
-#endif                                       // ALLOC_TEMP_BUFFERS_AT_RUN_TIME
+  NVWrapperForCVMat(&_srcImg, &_srcVFX);  // _srcVFX is an alias for _srcImg
+  NVWrapperForCVMat(&_dstImg, &_dstVFX);  // _dstVFX is an alias for _dstImg
 
   _inited = true;
 
@@ -471,27 +577,19 @@ bail:
 }
 
 FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
-  CUstream stream = 0;
   NvCV_Status vfxErr;
 
-  if (!_upscaleEff) return errEffect;
+  if (!_chain.numStages()) return errEffect;
   _srcImg = cv::imread(inFile);
   if (!_srcImg.data) return errRead;
 
-  BAIL_IF_ERR(vfxErr = allocBuffers(_srcImg.cols, _srcImg.rows));
-
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_upscaleEff, NVVFX_INPUT_IMAGE, &_interGpuRGBAu8));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_upscaleEff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(_upscaleEff, NVVFX_CUDA_STREAM, stream));
-
-  BAIL_IF_ERR(vfxErr = NvVFX_Load(_upscaleEff));
-  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_interGpuRGBAu8, 1.f, stream, &_tmpVFX));
-  BAIL_IF_ERR(vfxErr = NvVFX_Run(_upscaleEff, 0));  // _interGpuBuf --> _dstGpuBuf
-  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf, &_dstVFX, 1.f, stream,
-                                          &_tmpVFX));  // _dstGpuBuf --> _dstTmpVFX --> _dstVFX
+  BAIL_IF_ERR(vfxErr = allocBuffers(_srcImg.cols, _srcImg.rows));  // This also loads the effects
+  BAIL_IF_ERR(vfxErr = _chain.upload(&_srcVFX, 0));
+  BAIL_IF_ERR(vfxErr = _chain.run(0));
+  BAIL_IF_ERR(vfxErr = _chain.download(0, &_dstVFX));
 
   if (outFile && outFile[0]) {
-    if (IsLossyImageFile(outFile)) fprintf(stderr, "WARNING: JPEG output file format will reduce image quality\n");
+    if (IsLossyImageFile(outFile)) APP_LOG_WARNING("JPEG output file format will reduce image quality\n");
     if (!cv::imwrite(outFile, _dstImg)) {
       printf("Error writing: \"%s\"\n", outFile);
       return errWrite;
@@ -507,12 +605,11 @@ bail:
 
 FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   const int fourcc_h264 = cv::VideoWriter::fourcc('H', '2', '6', '4');
-  CUstream stream = 0;
   FXApp::Err appErr = errNone;
   bool ok;
   cv::VideoWriter writer;
   NvCV_Status vfxErr;
-  unsigned frameNum;
+  unsigned frameNum, buf;
   VideoInfo info;
 
   cv::VideoCapture reader(inFile);
@@ -524,12 +621,22 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   GetVideoInfo(reader, inFile, &info);
   if (!(fourcc_h264 == info.codec ||
         cv::VideoWriter::fourcc('a', 'v', 'c', '1') == info.codec))  // avc1 is alias for h264
-    printf("Filters only target H264 videos, not %.4s\n", (char*)&info.codec);
+    APP_LOG_WARNING("Filters only target H264 videos, not %.4s\n", (char*)&info.codec);
 
-  BAIL_IF_ERR(vfxErr = allocBuffers(info.width, info.height));
+  BAIL_IF_ERR(vfxErr = allocBuffers(info.width, info.height));  // This also loads the effects
 
   if (outFile && !outFile[0]) outFile = nullptr;
-  if (outFile) {
+  if (outFile && YUVWriter::IsYUVFile(outFile)) {
+    if (!_yuvWriter.open(outFile, _dstVFX.width, _dstVFX.height, info.frameRate)) {
+      printf("Cannot open \"%s\" for YUV writing; the size of the output must be even\n", outFile);
+      return errWrite;
+    }
+    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_dstYUV, _dstVFX.width, _dstVFX.height, NVCV_YUV420, NVCV_U8,
+                                         (_yuvWriter.isNV12() ? NVCV_NV12 : NVCV_I420), NVCV_CPU, 1));
+    _dstYUV.colorspace = NVCV_709 | NVCV_VIDEO_RANGE | NVCV_CHROMA_INTSTITIAL;  // As the header of a .y4m file says
+    BAIL_IF_NULL(_dstYUV.pitch == (int)_dstYUV.width ? _dstYUV.pixels : nullptr, vfxErr, NVCV_ERR_MISMATCH);
+    outFile = nullptr;  // Not for cv::VideoWriter
+  } else if (outFile) {
     ok = writer.open(outFile, StringToFourcc(FLAG_codec), info.frameRate, cv::Size(_dstVFX.width, _dstVFX.height));
     if (!ok) {
       printf("Cannot open \"%s\" for video writing\n", outFile);
@@ -538,41 +645,161 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
     }
   }
 
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_upscaleEff, NVVFX_INPUT_IMAGE, &_interGpuRGBAu8));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_upscaleEff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(_upscaleEff, NVVFX_CUDA_STREAM, stream));
-  BAIL_IF_ERR(vfxErr = NvVFX_Load(_upscaleEff));
-
+  // Frame k is uploaded and run through the chain on the GPU while frame k-1 is downloaded, encoded and displayed, so
+  // the two frames alternate between two sets of input and output buffers, or share one with CUDA graphs (see
+  // CudaGraphLoader). The buffers between the effects are only used on the GPU, in stream order, so there is one set of
+  // them.
   for (frameNum = 0; reader.read(_srcImg); ++frameNum) {
     if (_srcImg.empty()) {
-      printf("Frame %u is empty\n", frameNum);
+      APP_LOG_WARNING("Frame %u is empty\n", frameNum);
     }
 
-    // transfer between intermediate buffers if selected method is Upscale
-    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_interGpuRGBAu8, 1.f, stream, &_tmpVFX));
-    BAIL_IF_ERR(vfxErr = NvVFX_Run(_upscaleEff, 0));
-    BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf, &_dstVFX, 1.f, stream, &_tmpVFX));
-
-    if (outFile) writer.write(_dstImg);
-    if (_show) {
-      drawFrameRate(_dstImg);
-      cv::imshow("Output", _dstImg);
-      int key = cv::waitKey(1);
-      if (key > 0) {
-        appErr = processKey(key);
-        if (errQuit == appErr) break;
-      }
-    }
-    if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+    buf = frameBuf(frameNum);
+    BAIL_IF_ERR(vfxErr = _chain.upload(&_srcVFX, buf));
+    if (frameNum)  // frame k-1; a download into pageable memory waits for the copy to complete
+      BAIL_IF_ERR(vfxErr = downloadFrame(frameBuf(frameNum - 1)));
+    BAIL_IF_ERR(vfxErr = _chain.run(buf));  // asynchronous
+    if (frameNum && errQuit == (appErr = outputFrame((outFile ? &writer : nullptr), frameNum - 1, info))) break;
+  }
+  if (frameNum && errQuit != appErr) {  // Flush the last frame
+    BAIL_IF_ERR(vfxErr = downloadFrame(frameBuf(frameNum - 1)));
+    outputFrame((outFile ? &writer : nullptr), frameNum - 1, info);
   }
 
   if (_progress) fprintf(stderr, "\n");
   reader.release();
   if (outFile) writer.release();
+  _yuvWriter.close();
 bail:
   return appErrFromVfxStatus(vfxErr);
 }
 
+// Download the output of the chain. For a YUV file, it is converted from the chain's RGBA as it is downloaded, which
+// saves both a BGR-sized download and the conversion that the encoder would make; if the SDK cannot convert it, it is
+// downloaded as BGR and converted on the CPU. The BGR frame is only downloaded otherwise if it is to be shown.
+NvCV_Status FXApp::downloadFrame(unsigned buf) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  if (_yuvWriter.isOpened() && _yuvOnGpu) {
+    vfxErr = _chain.download(buf, &_dstYUV);
+    if (NVCV_SUCCESS != vfxErr) {
+      APP_LOG_WARNING("The output cannot be converted to YUV on the GPU, so it will be converted on the CPU: %s\n",
+                      NvCV_GetErrorStringFromCode(vfxErr));
+      _yuvOnGpu = false;
+    }
+  }
+  if (!_yuvWriter.isOpened() || !_yuvOnGpu || _show) BAIL_IF_ERR(vfxErr = _chain.download(buf, &_dstVFX));
+  if (_yuvWriter.isOpened() && !_yuvOnGpu) _yuvWriter.convert(_dstImg, (unsigned char*)_dstYUV.pixels);
+bail:
+  return vfxErr;
+}
+
+// Write, display and report progress for _dstImg.
+// Returns errQuit if the user chose to quit.
+FXApp::Err FXApp::outputFrame(cv::VideoWriter* writer, unsigned frameNum, const VideoInfo& info) {
+  Err appErr = errNone;
+  if (writer) writer->write(_dstImg);
+  if (_yuvWriter.isOpened() && !_yuvWriter.write((const unsigned char*)_dstYUV.pixels)) return errWrite;
+  if (_show) {
+    drawFrameRate(_dstImg);
+    cv::imshow("Output", _dstImg);
+    int key = cv::waitKey(1);
+    if (key > 0) appErr = processKey(key);
+  }
+  if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+  return appErr;
+}
+
+// Time one stage of a cascade, alone, on a blank frame, loaded as the chain will be, with --f16 and --cuda_graph. The
+// stage is run a few times to warm up, and then timed over several runs, ending with a download, which waits for them.
+// A stage that cannot be loaded, e.g. because the effect does not support that scale at that size, cannot be run.
+static double MeasureStage(const CascadePlanner::Stage& stage) {
+  const unsigned warmUpRuns = 2, timedRuns = 10;
+  const ChainEffect* fx = FindChainEffect(stage.effect.c_str());
+  std::chrono::high_resolution_clock::time_point start;
+  EffectChain chain;
+  NvCVImage src, dst;
+  NvCV_Status vfxErr = NVCV_ERR_EFFECT;
+  double ms = -1.;
+
+  APP_LOG_INFO("Measuring %s (%s) %ux%u --> %u\n", stage.effect.c_str(), stage.settings.c_str(), stage.inWidth,
+               stage.inHeight, stage.outHeight);
+  if (!fx) goto bail;
+  BAIL_IF_ERR(vfxErr = chain.addStage(fx->selector, fx->format, stage.outHeight, fx->stateful));
+  BAIL_IF_ERR(vfxErr = SetChainParams(*fx, chain.effect(0)));
+  BAIL_IF_ERR(vfxErr = chain.load(stage.inWidth, stage.inHeight, FLAG_cudaGraph, FLAG_f16));
+  BAIL_IF_ERR(vfxErr =
+                  NvCVImage_Alloc(&src, stage.inWidth, stage.inHeight, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_CPU, 1));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&dst, chain.outputWidth(), chain.outputHeight(), NVCV_BGR, NVCV_U8, NVCV_CHUNKY,
+                                       NVCV_CPU, 1));
+  memset(src.pixels, 0, (size_t)src.pitch * src.height);
+  BAIL_IF_ERR(vfxErr = chain.upload(&src, 0));
+  for (unsigned i = 0; i < warmUpRuns + timedRuns; ++i) {
+    if (i == warmUpRuns) {
+      BAIL_IF_ERR(vfxErr = chain.download(0, &dst));
+      start = std::chrono::high_resolution_clock::now();
+    }
+    BAIL_IF_ERR(vfxErr = chain.run(0));
+  }
+  BAIL_IF_ERR(vfxErr = chain.download(0, &dst));
+  ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / timedRuns;
+bail:
+  if (NVCV_SUCCESS != vfxErr)
+    APP_LOG_INFO("%s %ux%u --> %u cannot be run: %s\n", stage.effect.c_str(), stage.inWidth, stage.inHeight,
+                 stage.outHeight, NvCV_GetErrorStringFromCode(vfxErr));
+  return ms;
+}
+
+// Choose the cheapest chain of scaling effects that takes the input file to --resolution at a quality tier. The cost
+// of each stage is read from --cost_table, or measured and added to it.
+static FXApp::Err PlanChain(const char* inFile, CascadePlanner::Quality quality, std::vector<ChainStep>* steps) {
+  CascadePlanner planner;
+  CascadePlanner::Plan plan;
+  unsigned width, height;
+
+  if (IsImageFile(inFile)) {
+    cv::Mat img = cv::imread(inFile);
+    if (!img.data) return FXApp::errRead;
+    width = img.cols;
+    height = img.rows;
+  } else {
+    cv::VideoCapture reader(inFile);
+    if (!reader.isOpened()) return FXApp::errRead;
+    width = (unsigned)reader.get(cv::CAP_PROP_FRAME_WIDTH);
+    height = (unsigned)reader.get(cv::CAP_PROP_FRAME_HEIGHT);
+  }
+
+  for (const ChainEffect& e : chainEffects)
+    if (noScaling != e.scaling)
+      planner.addEffect(e.name, fixedScaling == e.scaling, e.highQuality, CostSettings(e).c_str());
+  planner.loadCosts(FLAG_costTable.c_str());
+  bool ok = planner.plan(width, height, (unsigned)FLAG_resolution, quality, MeasureStage, &plan);
+  if (!planner.saveCosts(FLAG_costTable.c_str()))
+    APP_LOG_WARNING("Cannot write the cost table \"%s\"\n", FLAG_costTable.c_str());
+  for (const CascadePlanner::Plan& p : planner.candidates()) {
+    std::string str;
+    for (const CascadePlanner::Stage& s : p.stages)
+      str += (str.empty() ? "" : ",") + s.effect + ":" + std::to_string(s.outHeight);
+    if (p.ms < 0.)
+      APP_LOG_INFO("  %-28s cannot be run\n", str.c_str());
+    else
+      APP_LOG_INFO("  %-28s %7.2f ms, %3.0f%% high quality\n", str.c_str(), p.ms, 100. * p.hqFraction);
+  }
+  if (!ok) {
+    printf("No cascade of effects can scale %ux%u to a height of %d\n", width, height, FLAG_resolution);
+    return FXApp::errResolution;
+  }
+
+  steps->clear();
+  std::string str;
+  for (const CascadePlanner::Stage& s : plan.stages) {
+    ChainStep step = {FindChainEffect(s.effect.c_str()), s.outHeight};
+    steps->push_back(step);
+    str += (str.empty() ? "" : ",") + s.effect + ":" + std::to_string(s.outHeight);
+  }
+  printf("Chain: %s (%.2f ms per frame)\n", str.c_str(), plan.ms);
+  return FXApp::errNone;
+}
+
 int main(int argc, char** argv) {
   int nErrs = 0;
   FXApp::Err fxErr = FXApp::errNone;
@@ -586,6 +813,12 @@ int main(int argc, char** argv) {
     if (NVCV_SUCCESS != vfxErr)
       printf("%s: while configuring logger to \"%s\"\n", NvCV_GetErrorStringFromCode(vfxErr), FLAG_log.c_str());
   }
+  static StderrLogger appLogger;  // App diagnostics, as opposed to SDK diagnostics
+  AppLogSetSink(StderrLogger::Callback, &appLogger);
+  if (FLAG_debug)
+    AppLogSetLevel(APP_LOG_LEVEL_DEBUG);
+  else if (FLAG_verbose)
+    AppLogSetLevel(APP_LOG_LEVEL_INFO);
 
   if (FLAG_inFile.empty()) {
     std::cerr << "Please specify --in_file=XXX\n";
@@ -596,6 +829,31 @@ int main(int argc, char** argv) {
     ++nErrs;
   }
 
+  std::vector<ChainStep> chain;
+  CascadePlanner::Quality quality = CascadePlanner::best;
+  if (!FLAG_quality.empty()) {
+    if (!FLAG_chain.empty()) {
+      std::cerr << "Please specify either --chain or --quality, not both\n";
+      ++nErrs;
+    }
+    if (!FLAG_resolution) {
+      std::cerr << "Please specify --resolution=XXX, the height to which --quality scales\n";
+      ++nErrs;
+    }
+    if (!strcasecmp(FLAG_quality.c_str(), "fast"))
+      quality = CascadePlanner::fast;
+    else if (!strcasecmp(FLAG_quality.c_str(), "balanced"))
+      quality = CascadePlanner::balanced;
+    else if (strcasecmp(FLAG_quality.c_str(), "best")) {
+      std::cerr << "Please specify --quality=fast, balanced or best\n";
+      ++nErrs;
+    }
+  } else if (!ParseChain((FLAG_chain.empty() ? "Upscale" : FLAG_chain), &chain)) {
+    std::cerr << "Please specify --chain=XXX as a list of effects, with --resolution=XXX or a height for those that "
+                 "scale\n";
+    ++nErrs;
+  }
+
   app._progress = FLAG_progress;
   app.setShow(FLAG_show);
 
@@ -603,11 +861,11 @@ int main(int argc, char** argv) {
     Usage();
     fxErr = FXApp::errFlag;
   } else {
-    NvVFX_EffectSelector eff = NVVFX_FX_SR_UPSCALE;
-
-    fxErr = app.createEffects(eff);
+    if (!FLAG_quality.empty()) fxErr = PlanChain(FLAG_inFile.c_str(), quality, &chain);
     if (FXApp::errNone != fxErr) {
-      std::cerr << "Error creating effects \"" << eff << "\"\n";
+      std::cerr << "Error planning a chain of effects for --quality=" << FLAG_quality << "\n";
+    } else if (FXApp::errNone != (fxErr = app.createEffects(chain))) {
+      std::cerr << "Error creating effects \"" << FLAG_chain << "\"\n";
     } else {
       if (IsImageFile(FLAG_inFile.c_str()))
         fxErr = app.processImage(FLAG_inFile.c_str(), FLAG_outFile.c_str());
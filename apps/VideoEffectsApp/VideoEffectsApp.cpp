@@ -23,26 +23,52 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <set>
 #include <string>
-
+#include <thread>
+#include <vector>
+
+#include "appLog.h"
+#include "batchUtilities.h"
+#include "cudaGraphLoader.h"
+#include "deadlineScheduler.h"
+#include "frameGraph.h"
+#include "frameQueue.h"
+#include "latencyLog.h"
+#include "latestFrameReader.h"
+#include "nvCVLoggerExamples.h"
 #include "nvCVOpenCV.h"
 #include "nvVFXSuperRes.h"
 #include "nvVFXTransfer.h"
 #include "nvVFXUpscale.h"
 #include "nvVideoEffects.h"
 #include "opencv2/opencv.hpp"
+#include "renditionLadder.h"
+#include "resolutionController.h"
+#include "segmentJoiner.h"
+#include "staticFrameDetector.h"
 
 #ifdef _MSC_VER
 #define strcasecmp _stricmp
 #include <Windows.h>
+#include <io.h>
 #else  // !_MSC_VER
 #include <sys/stat.h>
 #endif  // _MSC_VER
 
+#ifdef HAVE_CUDA_RUNTIME
+#include <cuda_runtime_api.h>
+#endif  // HAVE_CUDA_RUNTIME
+
 #define BAIL_IF_ERR(err) \
   do {                   \
     if (0 != (err)) {    \
@@ -64,11 +90,17 @@
 #define DEFAULT_CODEC "H264"
 #endif  // _WIN32
 
-bool FLAG_debug = false, FLAG_verbose = false, FLAG_show = false, FLAG_progress = false, FLAG_webcam = false;
-float FLAG_strength = 0.f;
-int FLAG_mode = 0, FLAG_resolution = 0, FLAG_logLevel = NVCV_LOG_ERROR;
+bool FLAG_debug = false, FLAG_verbose = false, FLAG_show = false, FLAG_progress = false, FLAG_webcam = false,
+     FLAG_pipeline = false, FLAG_stubEffect = false, FLAG_latency = false, FLAG_replay = false, FLAG_cudaGraph = false,
+     FLAG_deadline = false, FLAG_skipStatic = false;
+float FLAG_strength = 0.f, FLAG_deadlineBudget = 1.f, FLAG_targetFps = 0.f, FLAG_staticThreshold = .5f;
+int FLAG_mode = 0, FLAG_resolution = 0, FLAG_logLevel = NVCV_LOG_ERROR, FLAG_queueDepth = 4, FLAG_ioThreads = 2,
+    FLAG_tileSize = 0, FLAG_tileOverlap = 16, FLAG_tileBatch = 4, FLAG_segments = 1, FLAG_benchFrames = 100;
 std::string FLAG_codec = DEFAULT_CODEC, FLAG_camRes = "1280x720", FLAG_inFile, FLAG_outFile, FLAG_outDir, FLAG_modelDir,
-            FLAG_effect, FLAG_log = "stderr";
+            FLAG_effect, FLAG_log = "stderr", FLAG_inDir, FLAG_inList, FLAG_latencyCsv, FLAG_renditions,
+            FLAG_benchmark, FLAG_benchEffects = "Transfer,Upscale,SuperRes", FLAG_benchIn = "540,720",
+            FLAG_benchOut = "1080,1440", FLAG_benchModes = "0,1", FLAG_benchStrengths = "0.4",
+            FLAG_lateFrames = "repeat", FLAG_adaptiveRes;
 
 // Set this when using OTA Updates
 // This path is used by nvVideoEffectsProxy.cpp to load the SDK dll
@@ -135,6 +167,10 @@ static void Usage() {
       "  --in_file=<path>           input file to be processed\n"
       "  --webcam                   use a webcam as the input\n"
       "  --out_file=<path>          output file to be written\n"
+      "  --in_dir=<path>            process all of the images in this directory, loading the effect only once\n"
+      "  --in_list=<path>           process all of the images listed in this file, one path per line\n"
+      "  --out_dir=<path>           the directory where the images from --in_dir or --in_list are written\n"
+      "  --io_threads=<N>           the number of threads decoding, and the number encoding, images (default 2)\n"
       "  --effect=<effect>          the effect to apply (Transfer, Upscale, SuperRes)\n"
       "  --show                     display the results in a window (for webcam, it is always true)\n"
       "  --strength=<value>         strength of the upscaling effect, [0.0, 1.0]\n"
@@ -143,10 +179,47 @@ static void Usage() {
       "  --cam_res=[WWWx]HHH        specify camera resolution as height or width x height\n"
       "                             supports 720 and 1080 resolutions (default \"720\") \n"
       "  --resolution=<height>      the desired height of the output\n"
+      "  --renditions=<h1,h2,...>   write a video for each of these heights, running the effect only once, at the\n"
+      "                             largest; \"out.mp4\" is written as \"out_2160p.mp4\", \"out_1080p.mp4\", ...\n"
       "  --model_dir=<path>         the path to the directory that contains the models\n"
+      "  --tile_size=<N>            apply SuperRes or Upscale to overlapping tiles of at most NxN source pixels,\n"
+      "                             to bound GPU memory for large frames (default 0: whole frames)\n"
+      "  --tile_overlap=<N>         the overlap between adjacent tiles, in source pixels (default 16)\n"
+      "  --tile_batch=<N>           the maximum number of tiles submitted to the effect at once (default 4)\n"
       "  --codec=<fourcc>           the fourcc code for the desired codec (default " DEFAULT_CODEC
       ")\n"
       "  --progress                 show progress\n"
+      "  --pipeline                 decode, apply the effect and encode videos concurrently on separate threads\n"
+      "  --queue_depth=<N>          the number of frames in flight in the pipeline (default 4)\n"
+      "  --segments=<N>             split a video file into N time segments, each processed by its own instance of a\n"
+      "                             stateless effect (Transfer, Upscale, SuperRes), and concatenate them (default 1)\n"
+      "  --cuda_graph               replay each frame's upload, effect and download from a CUDA graph, or else the\n"
+      "                             effect's kernels alone, to reduce the launch overhead\n"
+      "  --stub_effect              replace the effect with a CPU resize, to exercise the app without a GPU\n"
+      "  --latency                  report the latency from capture to encode and to display, at exit\n"
+      "  --latency_csv=<path>       also write the latency of every frame to a CSV file\n"
+      "  --replay                   play the input file as if it were a webcam, at its own frame rate\n"
+      "  --deadline                 skip the effect for frames that would be output too late to keep up with the\n"
+      "                             source's frame rate, and report how many were skipped\n"
+      "  --deadline_budget=<N>      the time allowed for processing each frame, from capture (or its time in the\n"
+      "                             file), in frame periods (default 1); it is output one frame period later\n"
+      "  --late_frames=<action>     what is output for a skipped frame: repeat (the last output) or pass (the input,\n"
+      "                             resized) (default repeat)\n"
+      "  --skip_static              repeat the last output for a frame that repeats the last frame run through the\n"
+      "                             effect, instead of running it again, and report how many were skipped\n"
+      "  --static_threshold=<N>     the largest mean difference, in 8-bit levels, of any 32x32 tile of a repeated\n"
+      "                             frame (default 0.5)\n"
+      "  --adaptive_res=<list>      a ladder of heights at which the effect can be run; the height is stepped down or\n"
+      "                             up the ladder to hold the target frame rate, starting at the largest\n"
+      "  --target_fps=<fps>         the frame rate to be held by --adaptive_res (default: the source's frame rate)\n"
+      "  --benchmark=<path>         run a headless benchmark, and write the results as JSON (.json) or CSV\n"
+      "  --bench_effects=<list>     the effects to be benchmarked (default \"Transfer,Upscale,SuperRes\")\n"
+      "  --bench_in=<list>          the heights of the input frames (default \"540,720\"); the frames are synthetic,\n"
+      "                             unless --in_file is given\n"
+      "  --bench_out=<list>         the heights of the output frames (default \"1080,1440\")\n"
+      "  --bench_modes=<list>       the SuperRes modes (default \"0,1\")\n"
+      "  --bench_strengths=<list>   the Upscale and SuperRes strengths (default \"0.4\")\n"
+      "  --bench_frames=<N>         the number of frames timed for each configuration (default 100)\n"
       "  --log=<file>               log SDK errors to a file, \"stderr\" or \"\" (default stderr)\n"
       "  --log_level=<N>            the desired log level: {0, 1, 2, 3} = {FATAL, ERROR, WARNING, INFO}, respectively "
       "(default 1)\n"
@@ -161,24 +234,54 @@ static int ParseMyArgs(int argc, char** argv) {
     const char* arg = *argv;
     if (arg[0] != '-') {
       continue;
-    } else if ((arg[1] == '-') &&                                      //
-               (GetFlagArgVal("verbose", arg, &FLAG_verbose) ||        //
-                GetFlagArgVal("in", arg, &FLAG_inFile) ||              //
-                GetFlagArgVal("in_file", arg, &FLAG_inFile) ||         //
-                GetFlagArgVal("out", arg, &FLAG_outFile) ||            //
-                GetFlagArgVal("out_file", arg, &FLAG_outFile) ||       //
-                GetFlagArgVal("effect", arg, &FLAG_effect) ||          //
-                GetFlagArgVal("show", arg, &FLAG_show) ||              //
-                GetFlagArgVal("webcam", arg, &FLAG_webcam) ||          //
-                GetFlagArgVal("cam_res", arg, &FLAG_camRes) ||         //
-                GetFlagArgVal("strength", arg, &FLAG_strength) ||      //
-                GetFlagArgVal("mode", arg, &FLAG_mode) ||              //
-                GetFlagArgVal("resolution", arg, &FLAG_resolution) ||  //
-                GetFlagArgVal("model_dir", arg, &FLAG_modelDir) ||     //
-                GetFlagArgVal("codec", arg, &FLAG_codec) ||            //
-                GetFlagArgVal("progress", arg, &FLAG_progress) ||      //
-                GetFlagArgVal("debug", arg, &FLAG_debug) ||            //
-                GetFlagArgVal("log", arg, &FLAG_log) ||                //
+    } else if ((arg[1] == '-') &&                                                 //
+               (GetFlagArgVal("verbose", arg, &FLAG_verbose) ||                   //
+                GetFlagArgVal("in", arg, &FLAG_inFile) ||                         //
+                GetFlagArgVal("in_file", arg, &FLAG_inFile) ||                    //
+                GetFlagArgVal("out", arg, &FLAG_outFile) ||                       //
+                GetFlagArgVal("out_file", arg, &FLAG_outFile) ||                  //
+                GetFlagArgVal("in_dir", arg, &FLAG_inDir) ||                      //
+                GetFlagArgVal("in_list", arg, &FLAG_inList) ||                    //
+                GetFlagArgVal("out_dir", arg, &FLAG_outDir) ||                    //
+                GetFlagArgVal("io_threads", arg, &FLAG_ioThreads) ||              //
+                GetFlagArgVal("effect", arg, &FLAG_effect) ||                     //
+                GetFlagArgVal("show", arg, &FLAG_show) ||                         //
+                GetFlagArgVal("webcam", arg, &FLAG_webcam) ||                     //
+                GetFlagArgVal("cam_res", arg, &FLAG_camRes) ||                    //
+                GetFlagArgVal("strength", arg, &FLAG_strength) ||                 //
+                GetFlagArgVal("mode", arg, &FLAG_mode) ||                         //
+                GetFlagArgVal("resolution", arg, &FLAG_resolution) ||             //
+                GetFlagArgVal("renditions", arg, &FLAG_renditions) ||             //
+                GetFlagArgVal("model_dir", arg, &FLAG_modelDir) ||                //
+                GetFlagArgVal("tile_size", arg, &FLAG_tileSize) ||                //
+                GetFlagArgVal("tile_overlap", arg, &FLAG_tileOverlap) ||          //
+                GetFlagArgVal("tile_batch", arg, &FLAG_tileBatch) ||              //
+                GetFlagArgVal("codec", arg, &FLAG_codec) ||                       //
+                GetFlagArgVal("progress", arg, &FLAG_progress) ||                 //
+                GetFlagArgVal("pipeline", arg, &FLAG_pipeline) ||                 //
+                GetFlagArgVal("queue_depth", arg, &FLAG_queueDepth) ||            //
+                GetFlagArgVal("segments", arg, &FLAG_segments) ||                 //
+                GetFlagArgVal("cuda_graph", arg, &FLAG_cudaGraph) ||              //
+                GetFlagArgVal("stub_effect", arg, &FLAG_stubEffect) ||            //
+                GetFlagArgVal("latency", arg, &FLAG_latency) ||                   //
+                GetFlagArgVal("latency_csv", arg, &FLAG_latencyCsv) ||            //
+                GetFlagArgVal("replay", arg, &FLAG_replay) ||                     //
+                GetFlagArgVal("deadline", arg, &FLAG_deadline) ||                 //
+                GetFlagArgVal("deadline_budget", arg, &FLAG_deadlineBudget) ||    //
+                GetFlagArgVal("late_frames", arg, &FLAG_lateFrames) ||            //
+                GetFlagArgVal("skip_static", arg, &FLAG_skipStatic) ||            //
+                GetFlagArgVal("static_threshold", arg, &FLAG_staticThreshold) ||  //
+                GetFlagArgVal("adaptive_res", arg, &FLAG_adaptiveRes) ||          //
+                GetFlagArgVal("target_fps", arg, &FLAG_targetFps) ||              //
+                GetFlagArgVal("benchmark", arg, &FLAG_benchmark) ||               //
+                GetFlagArgVal("bench_effects", arg, &FLAG_benchEffects) ||        //
+                GetFlagArgVal("bench_in", arg, &FLAG_benchIn) ||                  //
+                GetFlagArgVal("bench_out", arg, &FLAG_benchOut) ||                //
+                GetFlagArgVal("bench_modes", arg, &FLAG_benchModes) ||            //
+                GetFlagArgVal("bench_strengths", arg, &FLAG_benchStrengths) ||    //
+                GetFlagArgVal("bench_frames", arg, &FLAG_benchFrames) ||          //
+                GetFlagArgVal("debug", arg, &FLAG_debug) ||                       //
+                GetFlagArgVal("log", arg, &FLAG_log) ||                           //
                 GetFlagArgVal("log_level", arg, &FLAG_logLevel))) {
       continue;
     } else if (GetFlagArgVal("help", arg, &help)) {
@@ -226,6 +329,91 @@ static bool IsImageFile(const char* str) {
 
 static bool IsLossyImageFile(const char* str) { return HasOneOfTheseSuffixes(str, ".jpg", ".jpeg", nullptr); }
 
+// Gather the image files named by --in_dir and --in_list.
+// The list file has one path per line; blank lines and lines beginning with '#' are ignored.
+static bool GetImageFileList(std::vector<std::string>* files) {
+  if (!FLAG_inDir.empty()) {
+    std::vector<cv::String> names;
+    cv::glob(FLAG_inDir + "/*", names, false);
+    for (const cv::String& name : names)
+      if (IsImageFile(name.c_str())) files->push_back(name);
+  }
+  if (!FLAG_inList.empty()) {
+    std::ifstream list(FLAG_inList);
+    std::string line;
+    if (!list.is_open()) {
+      printf("Error: Could not open list: \"%s\"\n", FLAG_inList.c_str());
+      return false;
+    }
+    while (std::getline(list, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (!line.empty() && line[0] != '#') files->push_back(line);
+    }
+  }
+  return true;
+}
+
+// Parse a comma-separated list of heights, and sort them largest first, without duplicates.
+static bool ParseHeights(const std::string& str, std::vector<int>* heights) {
+  heights->clear();
+  for (const char* s = str.c_str(); *s;) {
+    char* end;
+    long h = strtol(s, &end, 10);
+    if (end == s || h <= 0 || (*end && *end != ',')) return false;
+    heights->push_back((int)h);
+    s = *end ? end + 1 : end;
+  }
+  std::sort(heights->begin(), heights->end(), std::greater<int>());
+  heights->erase(std::unique(heights->begin(), heights->end()), heights->end());
+  return !heights->empty();
+}
+
+// Append a suffix to the name of a file, before its extension, e.g. "out.mp4" --> "out_1080p.mp4".
+static std::string SuffixedPath(const std::string& file, const std::string& suffix) {
+  size_t dot = file.find_last_of('.'), slash = file.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = file.size();
+  return file.substr(0, dot) + "_" + suffix + file.substr(dot);
+}
+
+// The canonical form of the path of an existing file, so that two names for the same file compare equal; else empty.
+static std::string CanonicalPath(const std::string& path) {
+#ifdef _MSC_VER
+  char buf[_MAX_PATH];
+  return (_fullpath(buf, path.c_str(), sizeof(buf)) && 0 == _access(buf, 0)) ? std::string(buf) : std::string();
+#else   // !_MSC_VER
+  char* canon = realpath(path.c_str(), nullptr);
+  std::string str = canon ? canon : "";
+  free(canon);
+  return str;
+#endif  // _MSC_VER
+}
+
+// The paths of the output images for the given input images: the same file names, in the output directory. A name
+// already taken by an earlier image, from another directory, gets a numbered suffix, e.g. "a.png" --> "a_2.png". An
+// image whose output would overwrite one of the inputs gets an empty path, and is not written.
+static void OutputPaths(const char* outDir, const std::vector<std::string>& inFiles,
+                        std::vector<std::string>* outFiles) {
+  std::string dir = outDir;
+  std::set<std::string> inputs, taken;
+  if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') dir += '/';
+  for (const std::string& inFile : inFiles) inputs.insert(CanonicalPath(inFile));
+  outFiles->clear();
+  for (const std::string& inFile : inFiles) {
+    size_t slash = inFile.find_last_of("/\\");
+    std::string name = (slash == std::string::npos) ? inFile : inFile.substr(slash + 1), outName = name;
+    for (unsigned n = 2; taken.count(outName); ++n) outName = SuffixedPath(name, std::to_string(n));
+    taken.insert(outName);
+    std::string canon = CanonicalPath(dir + outName);  // Only a file that exists can be an input
+    if (!canon.empty() && inputs.count(canon)) {
+      APP_LOG_ERROR("Not writing \"%s\" over an input\n", (dir + outName).c_str());
+      outName.clear();
+    } else if (outName != name) {
+      APP_LOG_WARNING("\"%s\" is written as \"%s\", as its name is taken\n", inFile.c_str(), outName.c_str());
+    }
+    outFiles->push_back(outName.empty() ? outName : dir + outName);
+  }
+}
+
 static const char* DurationString(double sc) {
   static char buf[16];
   int hr, mn;
@@ -274,6 +462,9 @@ static int StringToFourcc(const std::string& str) {
   return x.i;
 }
 
+enum LatencyStage { latencyEncode, latencyDisplay, numLatencyStages };
+static const char* const latencyStageNames[numLatencyStages] = {"encode", "display"};
+
 struct FXApp {
   enum Err {
     errQuit = +1,  // Application errors
@@ -314,22 +505,72 @@ struct FXApp {
 
   FXApp() {
     _eff = nullptr;
+    _stream = nullptr;
     _effectName = nullptr;
     _inited = false;
+    _tileBatch = 0;
+    _cudaGraph = false;
+    _frameGraphs = false;
+    _boundBuf = -1;
+    _latency = nullptr;
+    _scheduler = nullptr;
+    _staticFrames = nullptr;
+    _rescaler = nullptr;
+    _rung = 0;
+    _mode = 0;
+    _standby = nullptr;
+    _swapBusy = false;
     _showFPS = false;
     _progress = false;
     _show = false;
     _enableEffect = true, _drawVisualization = true, _framePeriod = 0.f;
   }
-  ~FXApp() { NvVFX_DestroyEffect(_eff); }
+  ~FXApp() {
+    if (_swapThread.joinable()) _swapThread.join();
+    delete _standby.load();
+    for (FXApp* app : _rungApps) delete app;
+    destroyEffect();
+  }
 
   void setShow(bool show) { _show = show; }
   Err createEffect(const char* effectSelector, const char* modelDir);
+  Err createStubEffect(const char* effectSelector);
   void destroyEffect();
+  void requestSwap(const char* effectSelector, int mode);
+  bool commitSwap();
+  void swapEffect(FXApp& other);
+  NvCV_Status openRungs(unsigned width, unsigned height);
+  void switchRung(unsigned rung);
+  const cv::Mat& scaleToRung(const cv::Mat& src, unsigned rung);
   NvCV_Status allocBuffers(unsigned width, unsigned height);
   NvCV_Status allocTempBuffers();
+  NvCV_Status allocTileBuffers(NvCVImage_PixelFormat format, NvCVImage_ComponentType type, unsigned layout,
+                               unsigned alignment);
+  NvCV_Status reshapeEffect(unsigned width, unsigned height, bool* loaded = nullptr);
+  NvCV_Status captureFrameGraphs();
+  void releaseFrameGraphs();
+  bool resolutionChanged(const cv::Mat& src) const {
+    return !src.empty() && (src.cols != (int)_srcVFX.width || src.rows != (int)_srcVFX.height);
+  }
   Err processImage(const char* inFile, const char* outFile);
+  Err processImages(const std::vector<std::string>& inFiles, const char* outDir);
   Err processMovie(const char* inFile, const char* outFile);
+  Err processMovieSegmented(const char* inFile, const char* outFile);
+  Err processSegment(const char* inFile, SegmentJoiner* joiner, unsigned k, long long firstFrame, long long numFrames);
+  Err openRenditions(const char* outFile, const VideoInfo& info);
+  Err processMoviePipelined(LatestFrameReader& reader, cv::VideoWriter* writer, const VideoInfo& info);
+  NvCV_Status processFrame(const cv::Mat& src, cv::Mat& dst);
+  NvCV_Status processFrameTiled(const cv::Mat& src, cv::Mat& dst);
+  NvCV_Status uploadFrame(const cv::Mat& src, unsigned buf);
+  NvCV_Status runFrame(unsigned buf);
+  NvCV_Status runEffect(unsigned buf, bool enabled);
+  NvCV_Status runStaged(unsigned buf, bool enabled);
+  unsigned frameBuf(unsigned frameNum) const { return _cudaGraph ? 0 : (frameNum & 1); }
+  NvCV_Status downloadFrame(unsigned buf, cv::Mat& dst);
+  NvCV_Status fenceStream();
+  NvCV_Status benchmarkFrame(const cv::Mat& src, double ms[3]);
+  Err outputFrame(cv::Mat& img, cv::VideoWriter* writer, unsigned frameNum, const VideoInfo& info,
+                  LatencyLog::Clock::time_point captureTime);
   Err initCamera(cv::VideoCapture& cap);
   Err processKey(int key);
   void drawFrameRate(cv::Mat& img);
@@ -337,21 +578,66 @@ struct FXApp {
   Err appErrFromVfxStatus(NvCV_Status status) { return (Err)status; }
   const char* errorStringFromCode(Err code);
 
+  struct PipelineFrame {
+    cv::Mat src;  // The decoded frame
+    cv::Mat dst;  // The frame after the effect has been applied
+    unsigned frameNum;
+    LatencyLog::Clock::time_point captureTime;
+  };
+  struct Tile {
+    cv::Rect src;  // The tile in the source frame
+    cv::Rect dst;  // The same tile in the destination frame
+  };
+
   NvVFX_Handle _eff;
+  CUstream _stream;
   cv::Mat _srcImg;
   cv::Mat _dstImg;
-  NvCVImage _srcGpuBuf;
-  NvCVImage _dstGpuBuf;
+  NvCVImage _srcGpuBuf[2];  // Double-buffered, so that frame k+1 can be uploaded while frame k is being processed
+  NvCVImage _dstGpuBuf[2];
   NvCVImage _srcVFX;
   NvCVImage _dstVFX;
-  NvCVImage _tmpVFX;  // We use the same temporary buffer for source and dst, since it auto-shapes as needed
+  NvCVImage _tmpVFX;         // We use the same temporary buffer for source and dst, since it auto-shapes as needed
+  bool _cudaGraph;           // The effect replays a CUDA graph, captured for one set of buffers
+  bool _frameGraphs;         // Each frame is replayed from _graphs, rather than launched step by step
+  FrameGraph _graphs[2];     // The upload, run and download of a frame, captured for each set of staging buffers
+  NvCVImage _stageSrc[2];    // Pinned source frames, which the frame graphs upload to _srcGpuBuf[0]
+  NvCVImage _stageDst[2];    // Pinned destination frames, which the frame graphs download from _dstGpuBuf[0]
+  NvCVImage _graphTmpVFX;    // The temporary buffer of the frame graphs, which must not move once they are captured
+  int _boundBuf;             // The buffer set bound to the effect, or -1 if none
+  cv::Size _outSize;         // The frame size of the video writer, which cannot change mid-stream
+  cv::Mat _outImg;           // Output frames resized to _outSize, after the stream has changed resolution
+  cv::Mat _showImg;          // The displayed frame, with the frame rate drawn on it
+  RenditionLadder _ladder;   // Writes the output at several sizes, if there are renditions
+  std::vector<Tile> _tiles;  // Empty, unless frames are processed in tiles
+  unsigned _tileBatch;       // The number of tiles submitted to each run of the effect
+  NvCVImage _tileSrcBatch;   // A batch of source tiles on the GPU
+  NvCVImage _tileDstBatch;   // A batch of destination tiles on the GPU
+  cv::Mat _tileOut;          // One destination tile, downloaded
+  cv::Mat _tileF;            // One destination tile, as float
+  cv::Mat _tileWeight;       // The blending weight of each pixel in a destination tile
+  cv::Mat _tileNorm;         // The reciprocal of the sum of the tile weights at each destination pixel
+  cv::Mat _tileAcc;          // The weighted sum of the destination tiles
   bool _show;
   bool _inited;
   bool _showFPS;
   bool _progress;
-  bool _enableEffect;
+  std::atomic<bool> _enableEffect;  // Read once per frame by the effect thread of the pipeline, while keys are handled
+                                    // on the main thread
   bool _drawVisualization;
   const char* _effectName;
+  int _mode;                           // The SuperRes mode
+  std::atomic<FXApp*> _standby;        // An effect that has been loaded in the background, ready to be swapped in
+  std::atomic<bool> _swapBusy;         // An effect is being loaded, swapped in, or the old one destroyed
+  std::thread _swapThread;             // The thread that loads the new effect, then destroys the old one
+  LatencyLog* _latency;                // NULL unless latency is being measured
+  DeadlineScheduler* _scheduler;       // NULL unless frames are skipped to meet their deadlines
+  StaticFrameDetector* _staticFrames;  // NULL unless frames that repeat the last one run are skipped
+  ResolutionController* _rescaler;     // NULL unless the effect's input resolution adapts to hold a frame rate
+  std::vector<int> _rungHeights;       // The heights of the effect's input on the resolution ladder, smallest first
+  std::vector<FXApp*> _rungApps;       // An effect loaded for each rung, except the current one, which is this
+  std::vector<cv::Mat> _rungSrc;       // The source frame, scaled to each rung
+  unsigned _rung;                      // The rung at which the effect is running
   float _framePeriod;
   std::chrono::high_resolution_clock::time_point _lastTime;
 };
@@ -409,8 +695,19 @@ FXApp::Err FXApp::processKey(int key) {
     case 'P':
     case '%':
       _progress = !_progress;
+      break;
     case 'e':
-    case 'E':
+    case 'E': {  // Switch to the next effect: Transfer --> Upscale --> SuperRes --> Transfer
+      static const char* const effects[] = {NVVFX_FX_TRANSFER, NVVFX_FX_SR_UPSCALE, NVVFX_FX_SUPER_RES};
+      const unsigned numEffects = FLAG_resolution ? 3 : 1;  // The others need an output resolution
+      unsigned i = 0;
+      if (_swapBusy || !_rungApps.empty()) break;  // _effectName may be about to change, or is loaded on every rung
+      while (i < numEffects && strcmp(effects[i], _effectName)) ++i;
+      requestSwap(effects[(i + 1) % numEffects], _mode);
+    } break;
+    case 'm':
+    case 'M':  // Toggle the SuperRes mode
+      if (!_swapBusy && _rungApps.empty() && !strcmp(_effectName, NVVFX_FX_SUPER_RES)) requestSwap(_effectName, !_mode);
       break;
     case 'd':
     case 'D':
@@ -461,19 +758,181 @@ FXApp::Err FXApp::createEffect(const char* effectSelector, const char* modelDir)
   NvCV_Status vfxErr;
   BAIL_IF_ERR(vfxErr = NvVFX_CreateEffect(effectSelector, &_eff));
   _effectName = effectSelector;
+  _mode = FLAG_mode;
   // Do not set NVVFX_MODEL_DIRECTORY for NVVFX_FX_SR_UPSCALE or NVVFX_FX_TRANSFER feature as it is not a valid selector
   // for these features
   if (modelDir[0] != '\0' &&
       (strcmp(_effectName, NVVFX_FX_SR_UPSCALE) != 0 && strcmp(_effectName, NVVFX_FX_TRANSFER) != 0)) {
     BAIL_IF_ERR(vfxErr = NvVFX_SetString(_eff, NVVFX_MODEL_DIRECTORY, modelDir));
   }
+  BAIL_IF_ERR(vfxErr = NvVFX_CudaStreamCreate(&_stream));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(_eff, NVVFX_CUDA_STREAM, _stream));
 bail:
   return appErrFromVfxStatus(vfxErr);
 }
 
-void FXApp::destroyEffect() {
-  NvVFX_DestroyEffect(_eff);
+// The stub only produces output of the same size as the real effect, so that the rest of the app can be exercised
+// without a GPU.
+FXApp::Err FXApp::createStubEffect(const char* effectSelector) {
   _eff = nullptr;
+  _effectName = effectSelector;
+  _mode = FLAG_mode;
+  return errNone;
+}
+
+void FXApp::destroyEffect() {
+  releaseFrameGraphs();
+  if (_eff) {
+    NvVFX_DestroyEffect(_eff);
+    _eff = nullptr;
+  }
+  if (_stream) {
+    NvVFX_CudaStreamDestroy(_stream);
+    _stream = nullptr;
+  }
+}
+
+// Create and load another effect on a background thread, while the current effect keeps processing frames. The new
+// effect is run once on a blank frame, so that its first real frame does not pay for any lazy initialization.
+// commitSwap() then exchanges it for the current effect at a frame boundary.
+void FXApp::requestSwap(const char* effectSelector, int mode) {
+  unsigned width = _srcVFX.width, height = _srcVFX.height;
+  if (_swapBusy) return;
+  if (_swapThread.joinable()) _swapThread.join();  // The previous swap has finished
+  _swapBusy = true;
+  printf("Loading %s%s\n", effectSelector, (strcmp(effectSelector, NVVFX_FX_SUPER_RES) ? "" : (mode ? " 1" : " 0")));
+  _swapThread = std::thread([this, effectSelector, mode, width, height]() {
+    FXApp* next = new FXApp;
+    cv::Mat blank(height, width, CV_8UC3, cv::Scalar::all(0));
+    Err appErr = FLAG_stubEffect ? next->createStubEffect(effectSelector)
+                                 : next->createEffect(effectSelector, FLAG_modelDir.c_str());
+    NvCV_Status vfxErr = (NvCV_Status)appErr;
+    next->_mode = mode;
+    if (NVCV_SUCCESS == vfxErr) vfxErr = next->reshapeEffect(width, height);
+    if (NVCV_SUCCESS == vfxErr) vfxErr = next->processFrame(blank, next->_dstImg);  // Warm up
+    if (NVCV_SUCCESS != vfxErr) {
+      printf("Error loading %s: %s\n", effectSelector, NvCV_GetErrorStringFromCode(vfxErr));
+      delete next;
+      _swapBusy = false;
+      return;
+    }
+    _standby = next;
+  });
+}
+
+// If an effect has been loaded in the background, exchange it for the current one. This is called between frames, on
+// the thread that runs the effect. The old effect is destroyed on a background thread, so as not to stall the stream.
+// Returns true if the effect was swapped.
+bool FXApp::commitSwap() {
+  FXApp* old = _standby.exchange(nullptr);
+  if (!old) return false;
+  swapEffect(*old);
+  _swapThread.join();  // The loader has already finished
+  _swapThread = std::thread([this, old]() {
+    delete old;
+    _swapBusy = false;
+  });
+  printf("Switched to %s\n", _effectName);
+  return true;
+}
+
+// NvCVImage has no move semantics, but it has no pointers into itself, so it can be exchanged bytewise; the ownership
+// of its buffer moves with it.
+static void SwapImages(NvCVImage& a, NvCVImage& b) {
+  unsigned char tmp[sizeof(NvCVImage)];
+  memcpy(tmp, (void*)&a, sizeof(tmp));
+  memcpy((void*)&a, (void*)&b, sizeof(tmp));
+  memcpy((void*)&b, tmp, sizeof(tmp));
+}
+
+// Exchange the effect, and all of the buffers that are shaped for it, with another instance. The source frame belongs
+// to the stream, so it stays, and _srcVFX stays an alias for it; only the shape that the buffers were allocated for,
+// which is all that is read from _srcVFX, is exchanged, so that resolutionChanged() compares the next frame with it.
+void FXApp::swapEffect(FXApp& other) {
+  std::swap(_eff, other._eff);
+  std::swap(_stream, other._stream);
+  std::swap(_effectName, other._effectName);
+  std::swap(_mode, other._mode);
+  std::swap(_inited, other._inited);
+  std::swap(_cudaGraph, other._cudaGraph);
+  std::swap(_frameGraphs, other._frameGraphs);
+  std::swap(_boundBuf, other._boundBuf);
+  cv::swap(_dstImg, other._dstImg);
+  std::swap(_srcVFX.width, other._srcVFX.width);
+  std::swap(_srcVFX.height, other._srcVFX.height);
+  SwapImages(_dstVFX, other._dstVFX);
+  SwapImages(_tmpVFX, other._tmpVFX);
+  SwapImages(_graphTmpVFX, other._graphTmpVFX);
+  for (unsigned i = 0; i < 2; ++i) {
+    SwapImages(_srcGpuBuf[i], other._srcGpuBuf[i]);
+    SwapImages(_dstGpuBuf[i], other._dstGpuBuf[i]);
+    SwapImages(_stageSrc[i], other._stageSrc[i]);
+    SwapImages(_stageDst[i], other._stageDst[i]);
+    _graphs[i].swap(other._graphs[i]);
+  }
+  _tiles.swap(other._tiles);
+  std::swap(_tileBatch, other._tileBatch);
+  SwapImages(_tileSrcBatch, other._tileSrcBatch);
+  SwapImages(_tileDstBatch, other._tileDstBatch);
+  cv::swap(_tileOut, other._tileOut);
+  cv::swap(_tileF, other._tileF);
+  cv::swap(_tileWeight, other._tileWeight);
+  cv::swap(_tileNorm, other._tileNorm);
+  cv::swap(_tileAcc, other._tileAcc);
+}
+
+// The size of a frame scaled to a rung of the resolution ladder. The width is kept even, for the encoder.
+static cv::Size RungSize(int width, int height, int rungHeight) {
+  return cv::Size((width * rungHeight / height) & ~1, rungHeight);
+}
+
+// Load an instance of the effect for each rung of _rungHeights, except the largest, which is this one, and run each
+// once on a blank frame. Switching rungs is then an exchange of effects and buffers, as for a hot swap, so it
+// neither loads a model nor allocates memory; the price is a model and a set of buffers on the GPU for each rung.
+NvCV_Status FXApp::openRungs(unsigned width, unsigned height) {
+  const std::vector<int>& heights = _rungHeights;
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  _rungApps.assign(heights.size(), nullptr);
+  _rungSrc.resize(heights.size());
+  _rung = (unsigned)heights.size() - 1;
+  for (unsigned k = 0; k < heights.size(); ++k) {
+    cv::Size size = RungSize((int)width, (int)height, heights[k]);
+    _rungSrc[k].create(size, CV_8UC3);
+    _rungSrc[k].setTo(cv::Scalar::all(0));
+    if (k == _rung) {
+      vfxErr = reshapeEffect(size.width, size.height);
+    } else {
+      FXApp* app = _rungApps[k] = new FXApp;
+      vfxErr = (NvCV_Status)(FLAG_stubEffect ? app->createStubEffect(_effectName)
+                                             : app->createEffect(_effectName, FLAG_modelDir.c_str()));
+      app->_mode = _mode;
+      if (NVCV_SUCCESS == vfxErr) vfxErr = app->reshapeEffect(size.width, size.height);
+      if (NVCV_SUCCESS == vfxErr) vfxErr = app->processFrame(_rungSrc[k], app->_dstImg);  // Warm up
+    }
+    if (NVCV_SUCCESS != vfxErr) {
+      printf("Error loading %s for %dp: %s\n", _effectName, heights[k], NvCV_GetErrorStringFromCode(vfxErr));
+      break;
+    }
+  }
+  return vfxErr;
+}
+
+// Switch the effect to another rung of the ladder. The instance loaded for that rung trades places with this one.
+void FXApp::switchRung(unsigned rung) {
+  swapEffect(*_rungApps[rung]);
+  std::swap(_rungApps[rung], _rungApps[_rung]);
+  APP_LOG_INFO("Effect input switched from %dp to %dp\n", _rungHeights[_rung], _rungHeights[rung]);
+  _rung = rung;
+}
+
+// Scale a source frame to a rung of the ladder. Each rung has its own buffer, allocated when the ladder was opened, so
+// this only allocates if the source changes shape.
+const cv::Mat& FXApp::scaleToRung(const cv::Mat& src, unsigned rung) {
+  if (src.empty()) return src;
+  cv::Size size = RungSize(src.cols, src.rows, _rungHeights[rung]);
+  if (size == src.size()) return src;
+  cv::resize(src, _rungSrc[rung], size, 0, 0, cv::INTER_AREA);
+  return _rungSrc[rung];
 }
 
 // Allocate one temp buffer to be used for input and output. Reshaping of the temp buffer in NvCVImage_Transfer() is
@@ -483,8 +942,8 @@ void FXApp::destroyEffect() {
 // memory at load time.
 NvCV_Status FXApp::allocTempBuffers() {
   NvCV_Status vfxErr;
-  BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_tmpVFX, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat,
-                                       _dstVFX.componentType, _dstVFX.planar, NVCV_GPU, 0));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_tmpVFX, _dstVFX.width, _dstVFX.height, _dstVFX.pixelFormat,
+                                         _dstVFX.componentType, _dstVFX.planar, NVCV_GPU, 0));
   BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_tmpVFX, _srcVFX.width, _srcVFX.height, _srcVFX.pixelFormat,
                                          _srcVFX.componentType, _srcVFX.planar, NVCV_GPU, 0));
 bail:
@@ -500,22 +959,35 @@ static NvCV_Status CheckScaleIsotropy(const NvCVImage* src, const NvCVImage* dst
   return NVCV_SUCCESS;
 }
 
+// The GPU buffers are reallocated only when they need to grow: NvCVImage_Realloc() reshapes an image in place when its
+// existing buffer is large enough. This can be called again whenever the source resolution changes.
 NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
   NvCV_Status vfxErr = NVCV_SUCCESS;
 
-  if (_inited) return NVCV_SUCCESS;
+  if (_inited && width == _srcVFX.width && height == _srcVFX.height) return NVCV_SUCCESS;
 
-  if (!_srcImg.data) {
-    _srcImg.create(height, width, CV_8UC3);  // src CPU
-    BAIL_IF_NULL(_srcImg.data, vfxErr, NVCV_ERR_MEMORY);
+  _srcImg.create(height, width, CV_8UC3);  // src CPU; this is a no-op if the decoder has already shaped it
+  BAIL_IF_NULL(_srcImg.data, vfxErr, NVCV_ERR_MEMORY);
+  if (!_eff) {  // Stub effect: CPU buffers only
+    if (strcmp(_effectName, NVVFX_FX_TRANSFER) && FLAG_resolution)
+      _dstImg.create(FLAG_resolution, _srcImg.cols * FLAG_resolution / _srcImg.rows, _srcImg.type());
+    else
+      _dstImg.create(_srcImg.rows, _srcImg.cols, _srcImg.type());
+    BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
+    NVWrapperForCVMat(&_srcImg, &_srcVFX);
+    NVWrapperForCVMat(&_dstImg, &_dstVFX);
+    _inited = true;
+    return NVCV_SUCCESS;
   }
   if (!strcmp(_effectName, NVVFX_FX_TRANSFER)) {
     _dstImg.create(_srcImg.rows, _srcImg.cols, _srcImg.type());  // dst CPU
     BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
-    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_srcGpuBuf, _srcImg.cols, _srcImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
-                                         NVCV_GPU, 1));  // src GPU
-    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_dstGpuBuf, _dstImg.cols, _dstImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
-                                         NVCV_GPU, 1));  // dst GPU
+    for (NvCVImage& buf : _srcGpuBuf)
+      BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _srcImg.cols, _srcImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
+                                             NVCV_GPU, 1));  // src GPU
+    for (NvCVImage& buf : _dstGpuBuf)
+      BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _dstImg.cols, _dstImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
+                                             NVCV_GPU, 1));  // dst GPU
   } else if (!strcmp(_effectName, NVVFX_FX_SUPER_RES)) {
     if (!FLAG_resolution) {
       printf("--resolution has not been specified\n");
@@ -525,11 +997,17 @@ NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
     int dstWidth = _srcImg.cols * FLAG_resolution / _srcImg.rows;
     _dstImg.create(FLAG_resolution, dstWidth, _srcImg.type());  // dst CPU
     BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
-    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_srcGpuBuf, _srcImg.cols, _srcImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
-                                         NVCV_GPU, 1));  // src GPU
-    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_dstGpuBuf, _dstImg.cols, _dstImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
-                                         NVCV_GPU, 1));  // dst GPU
-    BAIL_IF_ERR(vfxErr = CheckScaleIsotropy(&_srcGpuBuf, &_dstGpuBuf));
+    if (FLAG_tileSize > 0) {
+      BAIL_IF_ERR(vfxErr = allocTileBuffers(NVCV_BGR, NVCV_F32, NVCV_PLANAR, 1));
+    } else {
+      for (NvCVImage& buf : _srcGpuBuf)
+        BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _srcImg.cols, _srcImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
+                                               NVCV_GPU, 1));  // src GPU
+      for (NvCVImage& buf : _dstGpuBuf)
+        BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _dstImg.cols, _dstImg.rows, NVCV_BGR, NVCV_F32, NVCV_PLANAR,
+                                               NVCV_GPU, 1));  // dst GPU
+      BAIL_IF_ERR(vfxErr = CheckScaleIsotropy(&_srcGpuBuf[0], &_dstGpuBuf[0]));
+    }
   } else if (!strcmp(_effectName, NVVFX_FX_SR_UPSCALE)) {
     if (!FLAG_resolution) {
       printf("--resolution has not been specified\n");
@@ -540,20 +1018,27 @@ NvCV_Status FXApp::allocBuffers(unsigned width, unsigned height) {
     int dstWidth = _srcImg.cols * FLAG_resolution / _srcImg.rows;
     _dstImg.create(FLAG_resolution, dstWidth, _srcImg.type());  // dst CPU
     BAIL_IF_NULL(_dstImg.data, vfxErr, NVCV_ERR_MEMORY);
-    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_srcGpuBuf, _srcImg.cols, _srcImg.rows, NVCV_RGBA, NVCV_U8, NVCV_INTERLEAVED,
-                                         NVCV_GPU, 32));  // src GPU
-    BAIL_IF_ERR(vfxErr = NvCVImage_Alloc(&_dstGpuBuf, _dstImg.cols, _dstImg.rows, NVCV_RGBA, NVCV_U8, NVCV_INTERLEAVED,
-                                         NVCV_GPU, 32));  // dst GPU
-    BAIL_IF_ERR(vfxErr = CheckScaleIsotropy(&_srcGpuBuf, &_dstGpuBuf));
+    if (FLAG_tileSize > 0) {
+      BAIL_IF_ERR(vfxErr = allocTileBuffers(NVCV_RGBA, NVCV_U8, NVCV_INTERLEAVED, 32));
+    } else {
+      for (NvCVImage& buf : _srcGpuBuf)
+        BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _srcImg.cols, _srcImg.rows, NVCV_RGBA, NVCV_U8,
+                                               NVCV_INTERLEAVED, NVCV_GPU, 32));  // src GPU
+      for (NvCVImage& buf : _dstGpuBuf)
+        BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&buf, _dstImg.cols, _dstImg.rows, NVCV_RGBA, NVCV_U8,
+                                               NVCV_INTERLEAVED, NVCV_GPU, 32));  // dst GPU
+      BAIL_IF_ERR(vfxErr = CheckScaleIsotropy(&_srcGpuBuf[0], &_dstGpuBuf[0]));
+    }
   }
   NVWrapperForCVMat(&_srcImg, &_srcVFX);  // _srcVFX is an alias for _srcImg
   NVWrapperForCVMat(&_dstImg, &_dstVFX);  // _dstVFX is an alias for _dstImg
 
 // #define ALLOC_TEMP_BUFFERS_AT_RUN_TIME    // Deferring temp buffer allocation is easier
 #ifndef ALLOC_TEMP_BUFFERS_AT_RUN_TIME       // Allocating temp buffers at load time avoids run time hiccups
-  BAIL_IF_ERR(vfxErr = allocTempBuffers());  // This uses _srcVFX and _dstVFX and allocates one buffer to be a temporary
-                                             // for src and dst
-#endif                                       // ALLOC_TEMP_BUFFERS_AT_RUN_TIME
+  if (_tiles.empty())  // Tiles only need a tile-sized temporary, which is shaped on first use
+    BAIL_IF_ERR(vfxErr = allocTempBuffers());  // This uses _srcVFX and _dstVFX and allocates one buffer to be a
+                                               // temporary for src and dst
+#endif  // ALLOC_TEMP_BUFFERS_AT_RUN_TIME
 
   _inited = true;
 
@@ -561,33 +1046,259 @@ bail:
   return vfxErr;
 }
 
+// Compute where each tile starts along one dimension. The tiles are spaced (tile - overlap) apart, and the last one is
+// aligned with the end, so it may overlap its neighbor by more than the others.
+static void TileStarts(int length, int tile, int overlap, std::vector<int>* starts) {
+  starts->clear();
+  for (int x = 0;; x += tile - overlap) {
+    if (x + tile >= length) {
+      starts->push_back(length - tile);
+      break;
+    }
+    starts->push_back(x);
+  }
+}
+
+// A blending weight that rises linearly over the first ramp pixels, is 1 in the middle, and falls over the last ramp.
+// It never reaches 0, so that it can be normalized where only one tile covers the frame border.
+static cv::Mat TileRamp(int size, int ramp) {
+  cv::Mat w(1, size, CV_32F);
+  for (int x = 0; x < size; ++x)
+    w.at<float>(x) = ramp ? std::min(1.f, std::min(x + .5f, size - x - .5f) / ramp) : 1.f;
+  return w;
+}
+
+static int Gcd(int a, int b) {
+  while (b) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Lay out overlapping tiles over the source frame, and allocate GPU buffers for one batch of tiles rather than for the
+// whole frame. The tiles all have the same size, so that they can be batched. Their size and spacing are multiples of
+// the smallest number of source pixels that scale to a whole number of destination pixels, so that the destination
+// tiles line up exactly. The blending weights, and their normalization, are computed once here rather than per frame.
+NvCV_Status FXApp::allocTileBuffers(NvCVImage_PixelFormat format, NvCVImage_ComponentType type, unsigned layout,
+                                    unsigned alignment) {
+  NvCV_Status vfxErr;
+  NvCVImage srcVFX, dstVFX;
+  std::vector<int> xs, ys;
+  int srcH = _srcImg.rows, dstH = _dstImg.rows;
+  int q = srcH / Gcd(srcH, dstH);
+  int tileW = std::min(FLAG_tileSize / q * q, _srcImg.cols), tileH = std::min(FLAG_tileSize / q * q, srcH);
+  int overlap = (std::max(FLAG_tileOverlap, 0) + q - 1) / q * q;
+  int dstTileW = tileW * dstH / srcH, dstTileH = tileH * dstH / srcH, dstOverlap = overlap * dstH / srcH;
+
+  NVWrapperForCVMat(&_srcImg, &srcVFX);
+  NVWrapperForCVMat(&_dstImg, &dstVFX);
+  BAIL_IF_ERR(vfxErr = CheckScaleIsotropy(&srcVFX, &dstVFX));
+  if (!tileW || !tileH || (tileW < _srcImg.cols && overlap >= tileW) || (tileH < srcH && overlap >= tileH)) {
+    printf("--tile_size=%d must be at least %d, and larger than --tile_overlap=%d\n", FLAG_tileSize, q,
+           FLAG_tileOverlap);
+    return NVCV_ERR_PARAMETER;
+  }
+  TileStarts(_srcImg.cols, tileW, overlap, &xs);
+  TileStarts(srcH, tileH, overlap, &ys);
+  _tiles.clear();
+  for (int y : ys) {
+    for (int x : xs) {
+      Tile t;
+      t.src = cv::Rect(x, y, tileW, tileH);
+      t.dst = cv::Rect(x * dstH / srcH, y * dstH / srcH, dstTileW, dstTileH);
+      _tiles.push_back(t);
+    }
+  }
+  _tileBatch = (unsigned)std::min<size_t>((FLAG_tileBatch > 1) ? FLAG_tileBatch : 1, _tiles.size());
+  BAIL_IF_ERR(vfxErr = ReallocateBatchBuffer(&_tileSrcBatch, _tileBatch, tileW, tileH, format, type, layout, NVCV_GPU,
+                                             alignment));
+  BAIL_IF_ERR(vfxErr = ReallocateBatchBuffer(&_tileDstBatch, _tileBatch, dstTileW, dstTileH, format, type, layout,
+                                             NVCV_GPU, alignment));
+  _tileOut.create(dstTileH, dstTileW, CV_8UC3);
+  {
+    cv::Mat w = TileRamp(dstTileH, dstOverlap).t() * TileRamp(dstTileW, dstOverlap);
+    cv::Mat w3[3] = {w, w, w};
+    cv::merge(w3, 3, _tileWeight);
+  }
+  _tileNorm = cv::Mat::zeros(_dstImg.rows, _dstImg.cols, CV_32FC3);
+  for (const Tile& t : _tiles) {
+    cv::Mat norm = _tileNorm(t.dst);
+    norm += _tileWeight;
+  }
+  cv::divide(1., _tileNorm, _tileNorm);
+  _tileAcc.create(_dstImg.rows, _dstImg.cols, CV_32FC3);
+  APP_LOG_INFO("%u tiles of %d x %d --> %d x %d, in batches of %u\n", (unsigned)_tiles.size(), tileW, tileH, dstTileW,
+               dstTileH, _tileBatch);
+bail:
+  return vfxErr;
+}
+
+// Whether the effect has to be loaded again after its input resolution changes. The Transfer effect has no model, so
+// rebinding its images, which runFrame() does for every frame, is enough.
+static bool EffectReloadsOnResize(const char* effectName) { return 0 != strcmp(effectName, NVVFX_FX_TRANSFER); }
+
+// Reshape the buffers for a new source resolution, and load the effect if this is the first time or its model requires
+// it. Otherwise, a change of resolution costs no more than reshaping the buffers, which only allocates when they grow.
+NvCV_Status FXApp::reshapeEffect(unsigned width, unsigned height, bool* loaded) {
+  NvCV_Status vfxErr;
+  bool load = _eff && (!_inited || EffectReloadsOnResize(_effectName));
+  bool frameGraphs = FLAG_cudaGraph && _eff && FrameGraph::Supported();
+  if (loaded) *loaded = false;
+  releaseFrameGraphs();  // They replay the addresses of the buffers, which may move
+  BAIL_IF_ERR(vfxErr = allocBuffers(width, height));
+  _boundBuf = -1;  // The buffers may have moved
+  if (load && _tiles.empty()) {
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf[0]));
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf[0]));
+    _boundBuf = 0;
+  } else if (load) {  // Tiled: set the first of the batched tiles in and out, and ask for a model for this batch size
+    NvCVImage nth;
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE,
+                                        NthImage(0, _tiles[0].src.height, &_tileSrcBatch, &nth)));
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE,
+                                        NthImage(0, _tiles[0].dst.height, &_tileDstBatch, &nth)));
+    vfxErr = NvVFX_SetU32(_eff, NVVFX_MODEL_BATCH, _tileBatch);
+    if (!(NVCV_SUCCESS == vfxErr || NVCV_ERR_MODELSUBSTITUTION == vfxErr)) goto bail;
+  }
+  if (load) {
+    if (!strcmp(_effectName, NVVFX_FX_SUPER_RES)) {
+      BAIL_IF_ERR(vfxErr = NvVFX_SetU32(_eff, NVVFX_MODE, (unsigned int)_mode));
+    }
+    // A graph is captured for a fixed set of buffers, so it is not used for tiles, whose views change every run. The
+    // whole frame is captured below if it can be, which needs the effect to launch its kernels itself.
+    vfxErr = CudaGraphLoader::Load(_eff, _effectName, FLAG_cudaGraph && _tiles.empty() && !frameGraphs, &_cudaGraph);
+    if (NVCV_ERR_MODELSUBSTITUTION == vfxErr) vfxErr = NVCV_SUCCESS;  // No model for this batch size; it still runs
+    BAIL_IF_ERR(vfxErr);
+    if (loaded) *loaded = true;
+  }
+  if (frameGraphs && _tiles.empty() && !_cudaGraph) {
+    vfxErr = captureFrameGraphs();
+    if (NVCV_SUCCESS != vfxErr) {  // Fall back to a graph of the effect alone, which needs it to be loaded again
+      APP_LOG_WARNING("%s frames could not be captured in CUDA graphs: %s\n", _effectName,
+                      NvCV_GetErrorStringFromCode(vfxErr));
+      releaseFrameGraphs();
+      vfxErr = load ? CudaGraphLoader::Load(_eff, _effectName, true, &_cudaGraph) : NVCV_SUCCESS;
+      BAIL_IF_ERR(vfxErr);
+    }
+  }
+bail:
+  return vfxErr;
+}
+
+// Process a batch of still images with one effect instance. A pool of threads reads and decodes images ahead of the
+// effect, and another pool encodes and writes the results, so the GPU is not kept waiting on file I/O. The effect is
+// loaded for the first image, and reshaped when the resolution changes. An image that cannot be read, reshaped for or
+// written is logged and counted, and the batch goes on.
+FXApp::Err FXApp::processImages(const std::vector<std::string>& inFiles, const char* outDir) {
+  struct ImageJob {
+    const std::string* inFile;
+    const std::string* outFile;
+    cv::Mat src;
+    cv::Mat dst;
+  };
+  const unsigned numWorkers = (FLAG_ioThreads > 1) ? (unsigned)FLAG_ioThreads : 1;
+  BoundedQueue<ImageJob*> decodedQ((FLAG_queueDepth > 1) ? (unsigned)FLAG_queueDepth : 1);
+  BoundedQueue<ImageJob*> encodeQ((FLAG_queueDepth > 1) ? (unsigned)FLAG_queueDepth : 1);
+  std::atomic<size_t> nextFile(0);
+  std::atomic<unsigned> numDecoders(numWorkers), numErrs(0);
+  std::vector<std::thread> workers;
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  ImageJob* job = nullptr;
+  unsigned numDone = 0, numLoads = 0;
+  bool shaped = false;
+  std::vector<std::string> outFiles;
+
+  if (outDir && !outDir[0]) outDir = nullptr;
+  if (outDir) OutputPaths(outDir, inFiles, &outFiles);
+  auto decode = [&]() {
+    for (size_t i; (i = nextFile++) < inFiles.size();) {
+      ImageJob* j = new ImageJob;
+      j->inFile = &inFiles[i];
+      j->outFile = outDir ? &outFiles[i] : nullptr;
+      j->src = cv::imread(inFiles[i]);
+      if (!j->src.data) {
+        APP_LOG_ERROR("Error reading: \"%s\"\n", inFiles[i].c_str());
+        ++numErrs;
+        delete j;
+      } else if (!decodedQ.push(j)) {
+        delete j;
+        break;
+      }
+    }
+    if (0 == --numDecoders) decodedQ.close();
+  };
+  auto encode = [&]() {
+    ImageJob* j;
+    while (encodeQ.pop(&j)) {
+      if (j->outFile->empty()) {  // It would have overwritten an input
+        ++numErrs;
+      } else if (!cv::imwrite(*j->outFile, j->dst)) {
+        APP_LOG_ERROR("Error writing: \"%s\"\n", j->outFile->c_str());
+        ++numErrs;
+      }
+      delete j;
+    }
+  };
+  for (unsigned i = 0; i < numWorkers; ++i) workers.emplace_back(decode);
+  for (unsigned i = 0; i < numWorkers; ++i) workers.emplace_back(encode);
+
+  while (decodedQ.pop(&job)) {
+    if (!shaped || !_inited || resolutionChanged(job->src)) {
+      bool loaded;
+      APP_LOG_DEBUG("Reshaping the effect for %d x %d\n", job->src.cols, job->src.rows);
+      if (NVCV_SUCCESS != (vfxErr = reshapeEffect(job->src.cols, job->src.rows, &loaded))) {
+        APP_LOG_ERROR("%s: \"%s\"\n", NvCV_GetErrorStringFromCode(vfxErr), job->inFile->c_str());
+        ++numErrs;
+        shaped = false;  // Reshape again for the next image, whatever its size
+        vfxErr = NVCV_SUCCESS;
+        delete job;
+        job = nullptr;
+        continue;
+      }
+      shaped = true;
+      if (loaded) ++numLoads;
+    }
+    job->dst.create(_dstImg.rows, _dstImg.cols, _dstImg.type());
+    BAIL_IF_ERR(vfxErr = processFrame(job->src, job->dst));
+    if (_show) {
+      cv::imshow("Output", job->dst);
+      cv::waitKey(1);
+    }
+    if (outDir) {
+      encodeQ.push(job);
+    } else {
+      delete job;
+    }
+    job = nullptr;
+    if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * ++numDone / inFiles.size());
+  }
+
+bail:
+  delete job;
+  decodedQ.close();  // Stop the decoders early if there was an error
+  while (decodedQ.pop(&job)) delete job;
+  encodeQ.close();  // The encoders finish the images already queued
+  for (std::thread& worker : workers) worker.join();
+  if (_progress) fprintf(stderr, "\n");
+  APP_LOG_INFO("%u images processed, %u errors, %u effect loads\n", numDone, (unsigned)numErrs, numLoads);
+  if (NVCV_SUCCESS != vfxErr) return appErrFromVfxStatus(vfxErr);
+  return numErrs ? (outDir ? errWrite : errRead) : errNone;
+}
+
 FXApp::Err FXApp::processImage(const char* inFile, const char* outFile) {
-  CUstream stream = 0;
   NvCV_Status vfxErr;
 
   if (!_eff) return errEffect;
   _srcImg = cv::imread(inFile);
   if (!_srcImg.data) return errRead;
 
-  BAIL_IF_ERR(vfxErr = allocBuffers(_srcImg.cols, _srcImg.rows));
-
-  // Since images are uploaded asynchronously, we may as well do this first.
-  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf, 1.f / 255.f, stream,
-                                          &_tmpVFX));  // _srcVFX--> _tmpVFX --> _srcGpuBuf
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(_eff, NVVFX_CUDA_STREAM, stream));
-  if (!strcmp(_effectName, NVVFX_FX_SUPER_RES)) {
-    BAIL_IF_ERR(vfxErr = NvVFX_SetU32(_eff, NVVFX_MODE, (unsigned int)FLAG_mode));
-  }
-
-  BAIL_IF_ERR(vfxErr = NvVFX_Load(_eff));
-  BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));  // _srcGpuBuf --> _dstGpuBuf
-  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf, &_dstVFX, 255.f, stream,
-                                          &_tmpVFX));  // _dstGpuBuf --> _tmpVFX --> _dstVFX
+  BAIL_IF_ERR(vfxErr = reshapeEffect(_srcImg.cols, _srcImg.rows));  // Allocate buffers and load the effect
+  BAIL_IF_ERR(vfxErr = processFrame(_srcImg, _dstImg));              // _srcImg --> GPU --> _dstImg
 
   if (outFile && outFile[0]) {
-    if (IsLossyImageFile(outFile)) fprintf(stderr, "WARNING: JPEG output file format will reduce image quality\n");
+    if (IsLossyImageFile(outFile)) APP_LOG_WARNING("JPEG output file format will reduce image quality\n");
     if (!cv::imwrite(outFile, _dstImg)) {
       printf("Error writing: \"%s\"\n", outFile);
       return errWrite;
@@ -603,13 +1314,20 @@ bail:
 
 FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   const int fourcc_h264 = cv::VideoWriter::fourcc('H', '2', '6', '4');
-  CUstream stream = 0;
   FXApp::Err appErr = errNone;
   bool ok;
   cv::VideoCapture reader;
+  LatestFrameReader frameReader;  // This must be closed before the reader is released
   cv::VideoWriter writer;
   NvCV_Status vfxErr;
-  unsigned frameNum;
+  unsigned frameNum, buf, rung;
+  bool pending = false;     // Frame k-1 has yet to be downloaded and output
+  bool skip;                // Frame k is too late for the effect
+  bool same;                // Frame k repeats the last frame run through the effect, whose output can be reused
+  bool repeatable = false;  // _dstImg holds the last output of the effect, which can be repeated for a skipped frame
+  LatencyLog::Clock::time_point captureTime[2];  // Of frames k and k-1, alternately
+  ResolutionController::Clock::time_point busyStart;
+  DeadlineScheduler::Clock::time_point runStart;
   VideoInfo info;
 
   if (inFile && !inFile[0]) inFile = nullptr;  // Set file paths to NULL if zero length
@@ -632,13 +1350,20 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
   GetVideoInfo(reader, (inFile ? inFile : "webcam"), &info);
   if (!(fourcc_h264 == info.codec ||
         cv::VideoWriter::fourcc('a', 'v', 'c', '1') == info.codec))  // avc1 is alias for h264
-    printf("Filters only target H264 videos, not %.4s\n", (char*)&info.codec);
+    APP_LOG_WARNING("Filters only target H264 videos, not %.4s\n", (char*)&info.codec);
 
-  BAIL_IF_ERR(vfxErr = allocBuffers(info.width, info.height));
+  if (_rescaler)  // The effect starts at the largest rung
+    BAIL_IF_ERR(vfxErr = openRungs(info.width, info.height));
+  else
+    BAIL_IF_ERR(vfxErr = reshapeEffect(info.width, info.height));
 
   if (outFile && !outFile[0]) outFile = nullptr;
-  if (outFile) {
-    ok = writer.open(outFile, StringToFourcc(FLAG_codec), info.frameRate, cv::Size(_dstVFX.width, _dstVFX.height));
+  if (outFile && !FLAG_renditions.empty()) {
+    if (errNone != (appErr = openRenditions(outFile, info))) return appErr;
+    outFile = nullptr;  // The ladder writes the renditions
+  } else if (outFile) {
+    _outSize = cv::Size(_dstVFX.width, _dstVFX.height);
+    ok = writer.open(outFile, StringToFourcc(FLAG_codec), info.frameRate, _outSize);
     if (!ok) {
       printf("Cannot open \"%s\" for video writing\n", outFile);
       outFile = nullptr;
@@ -646,53 +1371,747 @@ FXApp::Err FXApp::processMovie(const char* inFile, const char* outFile) {
     }
   }
 
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf));
-  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(_eff, NVVFX_CUDA_STREAM, stream));
-  if (!strcmp(_effectName, NVVFX_FX_SUPER_RES)) {
-    BAIL_IF_ERR(vfxErr = NvVFX_SetU32(_eff, NVVFX_MODE, (unsigned int)FLAG_mode));
+  // A webcam is captured on its own thread, and only its newest frame is processed, so latency cannot build up when
+  // processing is slower than capture. A replayed file is treated in the same way.
+  frameReader.open(&reader, (FLAG_webcam || FLAG_replay), (FLAG_replay ? info.frameRate : 0.));
+  if (FLAG_pipeline) {
+    appErr = processMoviePipelined(frameReader, (outFile ? &writer : nullptr), info);
+    frameReader.close();
+    if (FLAG_webcam || FLAG_replay)
+      APP_LOG_INFO("%u of %u captured frames were dropped\n", frameReader.dropped(), frameReader.captured());
+    reader.release();
+    if (outFile) writer.release();
+    _ladder.close();
+    return appErr;
   }
-  BAIL_IF_ERR(vfxErr = NvVFX_Load(_eff));
 
-  for (frameNum = 0; reader.read(_srcImg); ++frameNum) {
+  // Frame k is uploaded and run on the GPU while frame k-1 is downloaded, encoded and displayed, so the two frames
+  // alternate between two sets of GPU buffers, or share one with a CUDA graph (see CudaGraphLoader); frame graphs
+  // alternate between two sets of pinned staging buffers instead (see captureFrameGraphs). The stub and tiled effects
+  // run synchronously. A webcam may renegotiate, or clips may be concatenated, so the resolution can change mid-stream;
+  // the pending frame is then flushed before reshaping. The same is done before swapping in an effect that has been
+  // loaded in the background, before skipping a frame that could not be output by its deadline or that repeats the last
+  // frame run, and before moving to another rung of the resolution ladder, where the frame is scaled to the rung's
+  // height before it is uploaded. The deadline scheduler is given the time from uploading a frame until the frame
+  // before it has been downloaded, which, in steady state, is the time taken by one frame on the GPU.
+  if (_scheduler) _scheduler->start((info.frameRate > 0. ? info.frameRate : 30.), FLAG_deadlineBudget,
+                                    (FLAG_webcam || FLAG_replay), ((!_eff || !_tiles.empty()) ? 0u : 1u));
+  if (_rescaler) {
+    std::vector<double> pixels;
+    for (const cv::Mat& img : _rungSrc) pixels.push_back((double)img.total());
+    _rescaler->start(pixels, (FLAG_targetFps > 0.f ? FLAG_targetFps : (info.frameRate > 0. ? info.frameRate : 30.)),
+                     _rung);
+  }
+  for (frameNum = 0; frameReader.read(_srcImg, &captureTime[frameNum & 1]); ++frameNum) {
+    busyStart = ResolutionController::Clock::now();  // Waiting for the frame to be captured is not counted
     if (_srcImg.empty()) {
-      printf("Frame %u is empty\n", frameNum);
+      APP_LOG_WARNING("Frame %u is empty\n", frameNum);
     }
 
-    // _srcVFX   --> _srcTmpVFX --> _srcGpuBuf --> _dstGpuBuf --> _dstTmpVFX --> _dstVFX
-    if (_enableEffect) {
-      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_srcGpuBuf, 1.f / 255.f, stream, &_tmpVFX));
-      BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
-      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf, &_dstVFX, 255.f, stream, &_tmpVFX));
-    } else {
-      BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_srcVFX, &_dstVFX, 1.f / 255.f, stream, &_tmpVFX));
+    rung = _rescaler ? _rescaler->rung() : _rung;
+    const cv::Mat& src = _rescaler ? scaleToRung(_srcImg, rung) : _srcImg;  // The effect's input
+    skip = _scheduler && !_scheduler->admit(frameNum, captureTime[frameNum & 1]);
+    same = !skip && repeatable && _staticFrames && _staticFrames->isRepeat(src);
+    if (skip || same || _standby.load() || rung != _rung || resolutionChanged(src)) {
+      if (pending) {
+        pending = false;
+        BAIL_IF_ERR(vfxErr = downloadFrame(frameBuf(frameNum - 1), _dstImg));
+        if (errQuit == (appErr = outputFrame(_dstImg, (outFile ? &writer : nullptr), frameNum - 1, info,
+                                             captureTime[(frameNum - 1) & 1])))
+          break;
+      }
+      if (commitSwap()) repeatable = false;
+      if (rung != _rung) {
+        switchRung(rung);
+        repeatable = false;
+      }
+      if (resolutionChanged(src)) {
+        APP_LOG_INFO("Frame %u: resolution changed to %d x %d\n", frameNum, src.cols, src.rows);
+        BAIL_IF_ERR(vfxErr = reshapeEffect(src.cols, src.rows));
+        repeatable = false;
+      }
     }
-
-    if (outFile) writer.write(_dstImg);
-
-    if (_show) {
-      drawFrameRate(_dstImg);
-      cv::imshow("Output", _dstImg);
-      int key = cv::waitKey(1);
-      if (key > 0) {
-        appErr = processKey(key);
-        if (errQuit == appErr) break;
+    same = same && repeatable;  // Unless the effect has just been swapped
+    if (skip || same) {  // Repeat the last output, as encoded, without the overlay; or pass the input through
+      if (!repeatable || (!same && FLAG_lateFrames != "repeat")) {
+        cv::resize(_srcImg, _dstImg, _dstImg.size(), 0, 0, cv::INTER_LINEAR);
+        repeatable = false;  // _dstImg no longer holds the effect's output for a repeated frame
       }
+      if (errQuit ==
+          (appErr = outputFrame(_dstImg, (outFile ? &writer : nullptr), frameNum, info, captureTime[frameNum & 1])))
+        break;
+      continue;
+    }
+    repeatable = true;  // By the time another frame is skipped, this one will have been output into _dstImg
+    if (_staticFrames) _staticFrames->keep(src);
+    runStart = DeadlineScheduler::Clock::now();
+    if (!_eff || !_tiles.empty()) {
+      BAIL_IF_ERR(vfxErr = processFrame(src, _dstImg));
+      if (_scheduler) _scheduler->measured(DeadlineScheduler::Clock::now() - runStart);
+      if (errQuit ==
+          (appErr = outputFrame(_dstImg, (outFile ? &writer : nullptr), frameNum, info, captureTime[frameNum & 1])))
+        break;
+    } else {
+      buf = frameBuf(frameNum);
+      BAIL_IF_ERR(vfxErr = uploadFrame(src, buf));  // frame k   --> _srcGpuBuf[buf]
+      if (pending)  // frame k-1 <-- _dstGpuBuf[buf ^ 1], or _dstGpuBuf[0] for graphs
+        BAIL_IF_ERR(vfxErr = downloadFrame(frameBuf(frameNum - 1), _dstImg));
+      BAIL_IF_ERR(vfxErr = runFrame(buf));  // asynchronous
+      if (pending && _scheduler) _scheduler->measured(DeadlineScheduler::Clock::now() - runStart);
+      if (pending && errQuit == (appErr = outputFrame(_dstImg, (outFile ? &writer : nullptr), frameNum - 1, info,
+                                                      captureTime[(frameNum - 1) & 1])))
+        break;
+      pending = true;
     }
-    if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+    if (_rescaler) _rescaler->update(ResolutionController::Clock::now() - busyStart);  // Choose the next frame's rung
+  }
+  if (pending && errQuit != appErr) {  // Flush the last frame
+    BAIL_IF_ERR(vfxErr = downloadFrame(frameBuf(frameNum - 1), _dstImg));
+    outputFrame(_dstImg, (outFile ? &writer : nullptr), frameNum - 1, info, captureTime[(frameNum - 1) & 1]);
   }
 
   if (_progress) fprintf(stderr, "\n");
+  frameReader.close();
+  if (FLAG_webcam || FLAG_replay)
+    APP_LOG_INFO("%u of %u captured frames were dropped\n", frameReader.dropped(), frameReader.captured());
   reader.release();
   if (outFile) writer.release();
+bail:
+  _ladder.close();
+  return appErrFromVfxStatus(vfxErr);
+}
+
+// A stateless effect gives the same result for a frame, whatever frames came before it, so a video can be split into
+// time segments that are processed independently.
+static bool EffectIsStateless(const char* effectName) {
+  return !strcmp(effectName, NVVFX_FX_TRANSFER) || !strcmp(effectName, NVVFX_FX_SR_UPSCALE) ||
+         !strcmp(effectName, NVVFX_FX_SUPER_RES);
+}
+
+// Split a video file into FLAG_segments time segments, and process each on its own thread, with its own instance of
+// the effect and its own CUDA stream; this instance takes the first segment. The SegmentJoiner hands the frames to
+// this thread in order, to be encoded once.
+FXApp::Err FXApp::processMovieSegmented(const char* inFile, const char* outFile) {
+  const unsigned numSegments = (unsigned)FLAG_segments;
+  std::vector<FXApp*> apps(numSegments, nullptr);
+  std::vector<Err> errs(numSegments, errNone);
+  SegmentJoiner joiner;
+  cv::VideoCapture reader;
+  cv::VideoWriter writer;
+  cv::Size outSize, dstSize;
+  cv::Mat outImg;
+  VideoInfo info;
+  Err appErr = errNone;
+
+  reader.open(inFile);
+  if (!reader.isOpened()) {
+    printf("Error: Could not open video: \"%s\"\n", inFile);
+    return errRead;
+  }
+  GetVideoInfo(reader, inFile, &info);
+  reader.release();
+  if (info.frameCount < (long long)numSegments) {
+    printf("Error: \"%s\" has too few frames to split into %u segments\n", inFile, numSegments);
+    return errRead;
+  }
+
+  apps[0] = this;
+  for (unsigned k = 1; k < numSegments && errNone == appErr; ++k) {
+    apps[k] = new FXApp;
+    appErr = FLAG_stubEffect ? apps[k]->createStubEffect(_effectName)
+                             : apps[k]->createEffect(_effectName, FLAG_modelDir.c_str());
+    apps[k]->_mode = _mode;
+  }
+  if (errNone == appErr) {
+    joiner.setQueueDepth((FLAG_queueDepth > 1) ? (unsigned)FLAG_queueDepth : 1);
+    dstSize = cv::Size(info.width, info.height);  // The processed frames, as allocBuffers() will shape them
+    if (strcmp(_effectName, NVVFX_FX_TRANSFER) && FLAG_resolution)
+      dstSize = cv::Size(info.width * FLAG_resolution / info.height, FLAG_resolution);
+    bool ok = joiner.run(
+        outFile, info.frameCount, dstSize, numSegments,
+        [&](unsigned k, long long first, long long count) {
+          errs[k] = apps[k]->processSegment(inFile, &joiner, k, first, count);
+          return errNone == errs[k];
+        },
+        [&](const cv::Mat& frame) {
+          if (!writer.isOpened()) {
+            outSize = frame.size();
+            if (!writer.open(outFile, StringToFourcc(FLAG_codec), info.frameRate, outSize)) {
+              printf("Cannot open \"%s\" for video writing\n", outFile);
+              appErr = errWrite;
+              return false;
+            }
+          }
+          if (frame.size() == outSize) {
+            writer.write(frame);
+          } else {  // The resolution changed mid-stream
+            cv::resize(frame, outImg, outSize, 0, 0, cv::INTER_AREA);
+            writer.write(outImg);
+          }
+          return true;
+        });
+    for (unsigned k = 0; k < numSegments && errNone == appErr; ++k) appErr = errs[k];
+    if (!ok && errNone == appErr) appErr = errRead;  // A segment gave too few frames
+  }
+  for (unsigned k = 1; k < numSegments; ++k) delete apps[k];
+  writer.release();
+  return appErr;
+}
+
+// Process frames [firstFrame, firstFrame + numFrames) of a video file, as segment k of the joiner.
+FXApp::Err FXApp::processSegment(const char* inFile, SegmentJoiner* joiner, unsigned k, long long firstFrame,
+                                 long long numFrames) {
+  cv::VideoCapture reader;
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  long long n;
+
+  reader.open(inFile);
+  if (!reader.isOpened()) return errRead;
+  if (firstFrame && (!reader.set(cv::CAP_PROP_POS_FRAMES, (double)firstFrame) ||
+                     (long long)reader.get(cv::CAP_PROP_POS_FRAMES) != firstFrame)) {
+    printf("Error: Could not seek to frame %lld of \"%s\"\n", firstFrame, inFile);
+    return errRead;
+  }
+  for (n = 0; n < numFrames && reader.read(_srcImg); ++n) {
+    if (resolutionChanged(_srcImg)) BAIL_IF_ERR(vfxErr = reshapeEffect(_srcImg.cols, _srcImg.rows));
+    BAIL_IF_ERR(vfxErr = processFrame(_srcImg, _dstImg));
+    if (!joiner->put(k, _dstImg)) return errWrite;  // The join has failed
+  }
+  APP_LOG_INFO("Frames %lld to %lld processed\n", firstFrame, firstFrame + n - 1);
+  if (n < numFrames) {
+    printf("Error: \"%s\" ended %lld frames before the end of segment %u\n", inFile, numFrames - n, k);
+    return errRead;
+  }
 bail:
   return appErrFromVfxStatus(vfxErr);
 }
 
+// Open a video writer for each rendition. The effect's output is the largest rendition, and the others are scaled
+// down from it, keeping its aspect ratio.
+FXApp::Err FXApp::openRenditions(const char* outFile, const VideoInfo& info) {
+  std::vector<int> heights;
+  const int topW = (int)_dstVFX.width, topH = (int)_dstVFX.height;
+
+  if (!ParseHeights(FLAG_renditions, &heights)) return errFlag;
+  if (heights[0] != topH)
+    APP_LOG_WARNING("The effect's output is %d high, so the %dp rendition is scaled\n", topH, heights[0]);
+  for (int h : heights) {
+    std::string path = SuffixedPath(outFile, std::to_string(h) + "p");
+    int w = (int)(((long long)topW * h / topH + 1) & ~1);  // Most codecs require an even width
+    if (!_ladder.addRendition(path, StringToFourcc(FLAG_codec), info.frameRate, cv::Size(w, h))) {
+      printf("Cannot open \"%s\" for video writing\n", path.c_str());
+      _ladder.close();
+      return errWrite;
+    }
+    APP_LOG_INFO("Writing %d x %d to \"%s\"\n", w, h, path.c_str());
+  }
+  _ladder.start(cv::Size(topW, topH), (FLAG_queueDepth > 1) ? (unsigned)FLAG_queueDepth : 1);
+  return errNone;
+}
+
+// src --> _tmpVFX --> _srcGpuBuf[buf], or src --> _stageSrc[buf] on the CPU, for the frame graph to upload.
+// The CPU images are wrapped on every call, since they may belong to different frames.
+NvCV_Status FXApp::uploadFrame(const cv::Mat& src, unsigned buf) {
+  NvCVImage srcVFX;
+  if (_frameGraphs) {
+    cv::Mat stage;
+    CVWrapperForNvCVImage(&_stageSrc[buf], &stage);
+    src.copyTo(stage);  // The frame graph that last read this buffer has been waited for by downloadFrame()
+    return NVCV_SUCCESS;
+  }
+  NVWrapperForCVMat(&src, &srcVFX);
+  return NvCVImage_Transfer(&srcVFX, &_srcGpuBuf[buf], 1.f / 255.f, _stream, &_tmpVFX);
+}
+
+// _srcGpuBuf[buf] --> _dstGpuBuf[buf], or the whole frame from _stageSrc[buf] to _stageDst[buf], replayed from its
+// graph. The work is queued on _stream, and the result is not waited for here.
+NvCV_Status FXApp::runFrame(unsigned buf) {
+  bool enabled = _enableEffect;
+  if (!_frameGraphs) return runEffect(buf, enabled);
+  if (!enabled) return runStaged(buf, false);  // Only the effect's frames were captured
+  return _graphs[buf].launch(_stream);
+}
+
+// _srcGpuBuf[buf] --> _dstGpuBuf[buf]
+// The images are bound whenever the buffer set changes; they alternate from frame to frame, unless the effect replays
+// a CUDA graph, which would have to be re-captured.
+NvCV_Status FXApp::runEffect(unsigned buf, bool enabled) {
+  NvCV_Status vfxErr;
+  if (!enabled) return NvCVImage_Transfer(&_srcGpuBuf[buf], &_dstGpuBuf[buf], 1.f, _stream, &_tmpVFX);
+  if (_boundBuf != (int)buf) {
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE, &_srcGpuBuf[buf]));
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE, &_dstGpuBuf[buf]));
+    _boundBuf = (int)buf;
+  }
+  BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
+bail:
+  return vfxErr;
+}
+
+// _dstGpuBuf[buf] --> _tmpVFX --> dst
+// A download into pageable memory does not return until the copy, and so everything queued before it on the stream,
+// has completed. A frame graph has already downloaded into _stageDst[buf], so it is waited for, then copied from.
+NvCV_Status FXApp::downloadFrame(unsigned buf, cv::Mat& dst) {
+  NvCV_Status vfxErr;
+  NvCVImage dstVFX;
+  cv::Mat stage;
+  if (_frameGraphs) {
+    BAIL_IF_ERR(vfxErr = FrameGraph::Synchronize(_stream));
+    CVWrapperForNvCVImage(&_stageDst[buf], &stage);
+    stage.copyTo(dst);
+    return NVCV_SUCCESS;
+  }
+  NVWrapperForCVMat(&dst, &dstVFX);
+  vfxErr = NvCVImage_Transfer(&_dstGpuBuf[buf], &dstVFX, 255.f, _stream, &_tmpVFX);
+bail:
+  return vfxErr;
+}
+
+// _stageSrc[buf] --> _srcGpuBuf[0] --> _dstGpuBuf[0] --> _stageDst[buf]
+// The work of one frame, as it is captured in _graphs[buf]. The stream runs one frame at a time, so the graphs
+// share one set of GPU buffers, which stays bound to the effect; only the pinned staging buffers alternate, so that
+// the CPU can fill one while the GPU reads the other.
+NvCV_Status FXApp::runStaged(unsigned buf, bool enabled) {
+  NvCV_Status vfxErr;
+  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_stageSrc[buf], &_srcGpuBuf[0], 1.f / 255.f, _stream, &_graphTmpVFX));
+  BAIL_IF_ERR(vfxErr = runEffect(0, enabled));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(&_dstGpuBuf[0], &_stageDst[buf], 255.f, _stream, &_graphTmpVFX));
+bail:
+  return vfxErr;
+}
+
+// Capture the upload, run and download of a frame in a CUDA graph for each set of staging buffers, so that a frame
+// costs one launch. Each frame is run once first, which binds the images and shapes the temporary buffer, since a
+// graph replays the addresses that it was captured with and nothing may be allocated while it is being captured.
+NvCV_Status FXApp::captureFrameGraphs() {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  unsigned buf;
+
+  for (buf = 0; buf < 2; ++buf) {
+    BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_stageSrc[buf], _srcImg.cols, _srcImg.rows, NVCV_BGR, NVCV_U8,
+                                           NVCV_CHUNKY, NVCV_CPU_PINNED, 0));
+    BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&_stageDst[buf], _dstImg.cols, _dstImg.rows, NVCV_BGR, NVCV_U8,
+                                           NVCV_CHUNKY, NVCV_CPU_PINNED, 0));
+    BAIL_IF_ERR(vfxErr = runStaged(buf, true));
+  }
+  BAIL_IF_ERR(vfxErr = FrameGraph::Synchronize(_stream));
+  for (buf = 0; buf < 2; ++buf)
+    BAIL_IF_ERR(vfxErr = _graphs[buf].capture(_stream, [this, buf]() { return runStaged(buf, true); }));
+  _frameGraphs = true;
+  APP_LOG_INFO("%s frames are replayed from CUDA graphs\n", _effectName);
+bail:
+  return vfxErr;
+}
+
+// Go back to launching each frame step by step, until the frame graphs are captured again.
+void FXApp::releaseFrameGraphs() {
+  _frameGraphs = false;
+  for (FrameGraph& graph : _graphs) graph.reset();
+}
+
+// Apply the effect to one frame, synchronously.
+NvCV_Status FXApp::processFrame(const cv::Mat& src, cv::Mat& dst) {
+  NvCV_Status vfxErr;
+
+  if (!_eff) {  // Stub effect
+    if (src.size() == dst.size())
+      src.copyTo(dst);
+    else
+      cv::resize(src, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+    return NVCV_SUCCESS;
+  }
+  if (!_tiles.empty()) return processFrameTiled(src, dst);
+  BAIL_IF_ERR(vfxErr = uploadFrame(src, 0));
+  BAIL_IF_ERR(vfxErr = runFrame(0));
+  BAIL_IF_ERR(vfxErr = downloadFrame(0, dst));
+bail:
+  return vfxErr;
+}
+
+// Apply the effect to one frame, a batch of tiles at a time. The source tiles are cut from the frame as they are
+// uploaded, and each destination tile is weighted as it is downloaded and accumulated, so that the seams are
+// cross-faded over the overlap. Only the tile batches and the stage buffer occupy GPU memory.
+NvCV_Status FXApp::processFrameTiled(const cv::Mat& src, cv::Mat& dst) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  NvCVImage srcVFX, tileVFX, view, nth;
+  unsigned i, n;
+
+  if (!_enableEffect) {
+    cv::resize(src, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+    return NVCV_SUCCESS;
+  }
+  NVWrapperForCVMat(&src, &srcVFX);
+  NVWrapperForCVMat(&_tileOut, &tileVFX);
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_INPUT_IMAGE,
+                                      NthImage(0, _tiles[0].src.height, &_tileSrcBatch, &nth)));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetImage(_eff, NVVFX_OUTPUT_IMAGE,
+                                      NthImage(0, _tiles[0].dst.height, &_tileDstBatch, &nth)));
+  _tileAcc.setTo(cv::Scalar::all(0));
+  for (size_t t = 0; t < _tiles.size(); t += n) {
+    n = (unsigned)std::min<size_t>(_tileBatch, _tiles.size() - t);
+    for (i = 0; i < n; ++i) {
+      const cv::Rect& r = _tiles[t + i].src;
+      NvCVImage_InitView(&view, &srcVFX, r.x, r.y, r.width, r.height);
+      BAIL_IF_ERR(vfxErr = TransferToNthImage(i, &view, &_tileSrcBatch, 1.f / 255.f, _stream, &_tmpVFX));
+    }
+    BAIL_IF_ERR(vfxErr = NvVFX_SetU32(_eff, NVVFX_BATCH_SIZE, n));  // The last batch may be short
+    BAIL_IF_ERR(vfxErr = NvVFX_Run(_eff, 0));
+    for (i = 0; i < n; ++i) {
+      BAIL_IF_ERR(vfxErr = TransferFromNthImage(i, &_tileDstBatch, &tileVFX, 255.f, _stream, &_tmpVFX));
+      _tileOut.convertTo(_tileF, CV_32F);
+      cv::Mat acc = _tileAcc(_tiles[t + i].dst);
+      cv::accumulateProduct(_tileF, _tileWeight, acc);
+    }
+  }
+  cv::multiply(_tileAcc, _tileNorm, _tileAcc);
+  _tileAcc.convertTo(dst, CV_8U);
+bail:
+  return vfxErr;
+}
+
+// Write, display and report progress for one output frame, and stamp its latency from capture at each stage.
+// Returns errQuit if the user chose to quit.
+FXApp::Err FXApp::outputFrame(cv::Mat& img, cv::VideoWriter* writer, unsigned frameNum, const VideoInfo& info,
+                              LatencyLog::Clock::time_point captureTime) {
+  Err appErr = errNone;
+  if (_latency) _latency->beginFrame(frameNum, captureTime);
+  if (_scheduler) _scheduler->finished(frameNum);
+  if (_ladder.isOpened()) {
+    _ladder.write(img);  // The renditions are scaled and encoded on their own threads
+    if (_latency) _latency->stamp(latencyEncode);
+  } else if (writer) {
+    if (img.size() == _outSize) {
+      writer->write(img);
+    } else {  // The resolution has changed since the writer was opened
+      cv::resize(img, _outImg, _outSize, 0, 0, cv::INTER_AREA);
+      writer->write(_outImg);
+    }
+    if (_latency) _latency->stamp(latencyEncode);
+  }
+  if (_show) {
+    if (_showFPS) img.copyTo(_showImg);  // img may be output again for a skipped frame, so it is not drawn on
+    cv::Mat& shown = _showFPS ? _showImg : img;
+    drawFrameRate(shown);
+    cv::imshow("Output", shown);
+    int key = cv::waitKey(1);  // The window is painted here
+    if (_latency) _latency->stamp(latencyDisplay);
+    if (key > 0) appErr = processKey(key);
+  }
+  if (_progress) fprintf(stderr, "\b\b\b\b%3.0f%%", 100.f * frameNum / info.frameCount);
+  return appErr;
+}
+
+// Decode, effect and encode run concurrently, connected by bounded queues. All frames are allocated up front and
+// circulate decode --> effect --> encode --> decode, so the number of frames bounds the number in flight. Each stage is
+// a single thread and the queues are FIFO, so the frames are written in the order that they were read. Encode and
+// display stay on the main thread, since the HighGUI window must be serviced there. If the resolution changes
+// mid-stream, the effect thread reshapes the effect, and each frame is reallocated the first time it is reused.
+FXApp::Err FXApp::processMoviePipelined(LatestFrameReader& reader, cv::VideoWriter* writer, const VideoInfo& info) {
+  const unsigned numFrames = (FLAG_queueDepth > 1) ? (unsigned)FLAG_queueDepth : 1;
+  std::vector<PipelineFrame> frames(numFrames);
+  BoundedQueue<PipelineFrame*> freeQ(numFrames), effectQ(numFrames), encodeQ(numFrames);
+  NvCV_Status effectErr = NVCV_SUCCESS;
+  PipelineFrame* frame;
+
+  for (PipelineFrame& f : frames) {
+    f.src.create(_srcImg.rows, _srcImg.cols, _srcImg.type());
+    f.dst.create(_dstImg.rows, _dstImg.cols, _dstImg.type());
+    if (!f.src.data || !f.dst.data) return errMemory;
+    freeQ.push(&f);
+  }
+
+  std::thread decoder([&]() {
+    PipelineFrame* f;
+    for (unsigned n = 0; freeQ.pop(&f); ++n) {
+      if (!reader.read(f->src, &f->captureTime)) break;
+      if (f->src.empty()) APP_LOG_WARNING("Frame %u is empty\n", n);
+      f->frameNum = n;
+      if (!effectQ.push(f)) break;
+    }
+    effectQ.close();  // End of stream
+  });
+  std::thread effector([&]() {
+    PipelineFrame* f;
+    while (effectQ.pop(&f)) {
+      commitSwap();
+      if (resolutionChanged(f->src)) {
+        APP_LOG_INFO("Frame %u: resolution changed to %d x %d\n", f->frameNum, f->src.cols, f->src.rows);
+        effectErr = reshapeEffect(f->src.cols, f->src.rows);
+      }
+      if (NVCV_SUCCESS == effectErr) {
+        f->dst.create(_dstImg.rows, _dstImg.cols, _dstImg.type());  // This is a no-op unless the resolution changed
+        effectErr = processFrame(f->src, f->dst);
+      }
+      if (NVCV_SUCCESS != effectErr) {
+        freeQ.close();  // Stop the decoder
+        effectQ.close();
+        break;
+      }
+      if (!encodeQ.push(f)) break;
+    }
+    encodeQ.close();
+  });
+
+  while (encodeQ.pop(&frame)) {
+    if (errQuit == outputFrame(frame->dst, writer, frame->frameNum, info, frame->captureTime)) break;
+    freeQ.push(frame);
+  }
+  freeQ.close();  // In case we quit early
+  effectQ.close();
+  encodeQ.close();
+  decoder.join();
+  effector.join();
+  if (_progress) fprintf(stderr, "\n");
+
+  return appErrFromVfxStatus(effectErr);
+}
+
+// Wait for all of the work queued on _stream, by downloading a single pixel into pageable memory, which does not
+// return until everything queued before it has completed. This lets the benchmark time each stage separately.
+NvCV_Status FXApp::fenceStream() {
+  NvCVImage gpuPixel, cpuPixel;
+  unsigned char pixel[3];
+  NvCVImage_InitView(&gpuPixel, &_dstGpuBuf[0], 0, 0, 1, 1);
+  NvCVImage_Init(&cpuPixel, 1, 1, sizeof(pixel), pixel, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_CPU);
+  return NvCVImage_Transfer(&gpuPixel, &cpuPixel, 255.f, _stream, &_tmpVFX);
+}
+
+// Apply the effect to one frame, timing the upload, run and download separately, in milliseconds. The upload and run
+// are each followed by a fence, whose cost is included in them. The stub effect has no transfers, so its resize is
+// timed as the run.
+NvCV_Status FXApp::benchmarkFrame(const cv::Mat& src, double ms[3]) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point t0, t1, t2, t3;
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+
+  if (!_eff) {
+    t0 = Clock::now();
+    vfxErr = processFrame(src, _dstImg);
+    ms[0] = ms[2] = 0.;
+    ms[1] = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return vfxErr;
+  }
+  t0 = Clock::now();
+  BAIL_IF_ERR(vfxErr = uploadFrame(src, 0));
+  BAIL_IF_ERR(vfxErr = fenceStream());
+  t1 = Clock::now();
+  BAIL_IF_ERR(vfxErr = runFrame(0));
+  BAIL_IF_ERR(vfxErr = fenceStream());
+  t2 = Clock::now();
+  BAIL_IF_ERR(vfxErr = downloadFrame(0, _dstImg));
+  t3 = Clock::now();
+  ms[0] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+  ms[1] = std::chrono::duration<double, std::milli>(t2 - t1).count();
+  ms[2] = std::chrono::duration<double, std::milli>(t3 - t2).count();
+bail:
+  return vfxErr;
+}
+
+// The GPU memory in use on the device, in bytes, or 0 if the app was built without the CUDA runtime. It is the whole
+// device's, so the difference between two samples is everything allocated in between: the effect's model and
+// workspace as well as the app's buffers, but also the allocations of any other process that shares the GPU.
+static size_t GpuMemoryInUse() {
+#ifdef HAVE_CUDA_RUNTIME
+  size_t freeBytes = 0, totalBytes = 0;
+  if (cudaSuccess != cudaMemGetInfo(&freeBytes, &totalBytes)) return 0;
+  return totalBytes - freeBytes;
+#else   // !HAVE_CUDA_RUNTIME
+  return 0;
+#endif  // HAVE_CUDA_RUNTIME
+}
+
+static std::vector<std::string> SplitList(const std::string& str) {
+  std::vector<std::string> items;
+  for (size_t start = 0, comma; start < str.size(); start = comma + 1) {
+    comma = str.find(',', start);
+    if (comma == std::string::npos) comma = str.size();
+    if (comma > start) items.push_back(str.substr(start, comma - start));
+  }
+  return items;
+}
+
+struct BenchmarkResult {
+  std::string effect, status;
+  int srcWidth, srcHeight, dstWidth, dstHeight, mode;
+  float strength;
+  double loadMs, uploadMs, runMs, downloadMs, frameMs, frameP95Ms, gpuPeakMB;
+};
+
+// Run one configuration of the benchmark, with a fresh instance of the effect, so that the load time is measured.
+// The globals that the effect is configured from are set for the duration. The GPU memory of the configuration is
+// sampled before the effect is created, and again after it is loaded and after every frame; the largest increase is
+// its peak, with the previous configuration's effect already destroyed. It is -1 if it cannot be measured.
+static BenchmarkResult BenchmarkConfig(const char* effect, const cv::Mat& src, int dstHeight, int mode,
+                                       float strength) {
+  typedef std::chrono::steady_clock Clock;
+  const int numWarmup = 5, numFrames = (FLAG_benchFrames > 0) ? FLAG_benchFrames : 1;
+  BenchmarkResult res = {effect, "ok", src.cols, src.rows, 0, 0, mode, strength, 0., 0., 0., 0., 0., 0., -1.};
+  std::vector<double> frameMs;
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  FXApp::Err appErr;
+  FXApp app;
+  Clock::time_point t0;
+  double ms[3];
+  size_t gpuBase, gpuPeak;
+
+  FLAG_resolution = dstHeight;
+  FLAG_strength = strength;
+  gpuBase = gpuPeak = GpuMemoryInUse();
+  t0 = Clock::now();
+  appErr = FLAG_stubEffect ? app.createStubEffect(effect) : app.createEffect(effect, FLAG_modelDir.c_str());
+  if (FXApp::errNone != appErr) {
+    res.status = app.errorStringFromCode(appErr);
+    return res;
+  }
+  app._mode = mode;
+  BAIL_IF_ERR(vfxErr = app.reshapeEffect(src.cols, src.rows));
+  res.loadMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  res.dstWidth = app._dstImg.cols;
+  res.dstHeight = app._dstImg.rows;
+  gpuPeak = std::max(gpuPeak, GpuMemoryInUse());
+
+  for (int i = 0; i < numWarmup; ++i) {
+    BAIL_IF_ERR(vfxErr = app.benchmarkFrame(src, ms));
+    gpuPeak = std::max(gpuPeak, GpuMemoryInUse());
+  }
+  for (int i = 0; i < numFrames; ++i) {
+    BAIL_IF_ERR(vfxErr = app.benchmarkFrame(src, ms));
+    gpuPeak = std::max(gpuPeak, GpuMemoryInUse());  // Between frames, so it is not timed
+    res.uploadMs += ms[0];
+    res.runMs += ms[1];
+    res.downloadMs += ms[2];
+    frameMs.push_back(ms[0] + ms[1] + ms[2]);
+  }
+  res.uploadMs /= numFrames;
+  res.runMs /= numFrames;
+  res.downloadMs /= numFrames;
+  res.frameMs = res.uploadMs + res.runMs + res.downloadMs;
+  std::sort(frameMs.begin(), frameMs.end());
+  res.frameP95Ms = frameMs[(size_t)(.95 * (frameMs.size() - 1) + .5)];
+  if (gpuBase) res.gpuPeakMB = (gpuPeak - gpuBase) / (1024. * 1024.);
+bail:
+  if (NVCV_SUCCESS != vfxErr) res.status = NvCV_GetErrorStringFromCode(vfxErr);
+  return res;
+}
+
+// Quote a string for a JSON or CSV field; error strings, for instance, may contain quotes.
+static std::string Quoted(const std::string& str, bool json) {
+  std::string q(1, '"');
+  char esc[8];
+  for (unsigned char c : str) {
+    if (c == '"') {
+      q += json ? "\\\"" : "\"\"";
+    } else if (json && c == '\\') {
+      q += "\\\\";
+    } else if (json && c < 0x20) {
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      q += esc;
+    } else {
+      q += (char)c;
+    }
+  }
+  return q + '"';
+}
+
+static bool WriteBenchmarkResults(const std::vector<BenchmarkResult>& results, const char* file) {
+  bool json = HasSuffix(file, ".json");
+  FILE* fd = fopen(file, "w");
+  if (!fd) return false;
+  if (json) {
+    fprintf(fd, "[\n");
+  } else {
+    fprintf(fd, "effect,src_width,src_height,dst_width,dst_height,mode,strength,status,load_ms,upload_ms,run_ms,"
+                "download_ms,frame_ms,frame_p95_ms,gpu_peak_mb\n");
+  }
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult& r = results[i];
+    if (json)
+      fprintf(fd,
+              "  {\"effect\": %s, \"src_width\": %d, \"src_height\": %d, \"dst_width\": %d, \"dst_height\": %d, "
+              "\"mode\": %d, \"strength\": %g, \"status\": %s, \"load_ms\": %.3f, \"upload_ms\": %.3f, "
+              "\"run_ms\": %.3f, \"download_ms\": %.3f, \"frame_ms\": %.3f, \"frame_p95_ms\": %.3f, "
+              "\"gpu_peak_mb\": %.1f}%s\n",
+              Quoted(r.effect, true).c_str(), r.srcWidth, r.srcHeight, r.dstWidth, r.dstHeight, r.mode, r.strength,
+              Quoted(r.status, true).c_str(), r.loadMs, r.uploadMs, r.runMs, r.downloadMs, r.frameMs, r.frameP95Ms,
+              r.gpuPeakMB, (i + 1 < results.size() ? "," : ""));
+    else
+      fprintf(fd, "%s,%d,%d,%d,%d,%d,%g,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n", r.effect.c_str(), r.srcWidth,
+              r.srcHeight, r.dstWidth, r.dstHeight, r.mode, r.strength, Quoted(r.status, false).c_str(), r.loadMs,
+              r.uploadMs, r.runMs, r.downloadMs, r.frameMs, r.frameP95Ms, r.gpuPeakMB);
+  }
+  if (json) fprintf(fd, "]\n");
+  return 0 == fclose(fd);
+}
+
+// Sweep effect x input height x output height x mode x strength, without a window or a video writer, and write the
+// steady-state frame time of each configuration, split into upload, run and download, with its load time and peak GPU
+// memory. The frames are synthetic, unless an input file is given, in which case its first frame is scaled to each
+// height. Mode only applies to SuperRes, and strength to Upscale and SuperRes, so the other effects are not swept over
+// them; Transfer does not scale, so it is not swept over the output height either. Heights are swept largest first.
+static FXApp::Err RunBenchmark() {
+  std::vector<std::string> effects = SplitList(FLAG_benchEffects), modes = SplitList(FLAG_benchModes),
+                           strengths = SplitList(FLAG_benchStrengths);
+  const std::vector<std::string> none(1, "0");
+  const std::vector<int> noHeight(1, 0);
+  std::vector<int> srcHeights, dstHeights;
+  std::vector<BenchmarkResult> results;
+  cv::Mat sample, src;
+
+  if (!ParseHeights(FLAG_benchIn, &srcHeights) || !ParseHeights(FLAG_benchOut, &dstHeights)) {
+    std::cerr << "--bench_in and --bench_out require lists of positive heights\n";
+    return FXApp::errFlag;
+  }
+  if (!FLAG_inFile.empty()) {
+    if (IsImageFile(FLAG_inFile.c_str())) {
+      sample = cv::imread(FLAG_inFile);
+    } else {
+      cv::VideoCapture reader(FLAG_inFile);
+      reader.read(sample);
+    }
+    if (sample.empty()) {
+      printf("Error reading: \"%s\"\n", FLAG_inFile.c_str());
+      return FXApp::errRead;
+    }
+  }
+  for (const std::string& effect : effects) {
+    bool isTransfer = !strcmp(effect.c_str(), NVVFX_FX_TRANSFER);
+    bool isSuperRes = !strcmp(effect.c_str(), NVVFX_FX_SUPER_RES);
+    for (int h : srcHeights) {
+      int w = (((sample.empty() ? 16 * h / 9 : sample.cols * h / sample.rows) + 1) & ~1);  // Even, as for codecs
+      if (sample.empty()) {
+        src.create(h, w, CV_8UC3);
+        cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(256));
+      } else {
+        cv::resize(sample, src, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+      }
+      for (int dstHeight : (isTransfer ? noHeight : dstHeights))
+        for (const std::string& mode : (isSuperRes ? modes : none))
+          for (const std::string& strength : (isTransfer ? none : strengths)) {
+            results.push_back(
+                BenchmarkConfig(effect.c_str(), src, dstHeight, atoi(mode.c_str()), strtof(strength.c_str(), nullptr)));
+            const BenchmarkResult& r = results.back();
+            printf("%-9s %4dx%-4d -> %4dx%-4d mode %d strength %.2f: %8.3f ms/frame (upload %.3f, run %.3f, download "
+                   "%.3f), load %.1f ms, %s\n",
+                   r.effect.c_str(), r.srcWidth, r.srcHeight, r.dstWidth, r.dstHeight, r.mode, r.strength, r.frameMs,
+                   r.uploadMs, r.runMs, r.downloadMs, r.loadMs, r.status.c_str());
+          }
+    }
+  }
+  if (!WriteBenchmarkResults(results, FLAG_benchmark.c_str())) {
+    printf("Error writing: \"%s\"\n", FLAG_benchmark.c_str());
+    return FXApp::errWrite;
+  }
+  return FXApp::errNone;
+}
+
 int main(int argc, char** argv) {
   FXApp::Err fxErr = FXApp::errNone;
   int nErrs;
   FXApp app;
+  LatencyLog latency(numLatencyStages, latencyStageNames);
+  DeadlineScheduler scheduler;
+  StaticFrameDetector staticFrames;
+  ResolutionController rescaler;
 
   nErrs = ParseMyArgs(argc, argv);
   if (nErrs) std::cerr << nErrs << " command line syntax problems\n";
@@ -701,42 +2120,120 @@ int main(int argc, char** argv) {
   if (NVCV_SUCCESS != vfxErr)
     printf("%s: while configuring logger to \"%s\"\n", NvCV_GetErrorStringFromCode(vfxErr), FLAG_log.c_str());
 
-  if (FLAG_verbose) {
+  static StderrLogger appLogger;  // App diagnostics, as opposed to SDK diagnostics
+  AppLogSetSink(StderrLogger::Callback, &appLogger);
+  if (FLAG_debug)
+    AppLogSetLevel(APP_LOG_LEVEL_DEBUG);
+  else if (FLAG_verbose)
+    AppLogSetLevel(APP_LOG_LEVEL_INFO);
+  if (!FLAG_benchmark.empty()) {  // Headless: no effect, output file or window is needed
+    fxErr = nErrs ? FXApp::errFlag : RunBenchmark();
+    if (nErrs) Usage();
+    if (fxErr) std::cerr << "Error: " << app.errorStringFromCode(fxErr) << std::endl;
+    return (int)fxErr;
   }
   if (FLAG_webcam) {
     // If webcam is on, enable showing the results and turn off displaying the progress
     if (FLAG_progress) FLAG_progress = !FLAG_progress;
     if (!FLAG_show) FLAG_show = !FLAG_show;
   }
-  if (FLAG_inFile.empty() && !FLAG_webcam) {
-    std::cerr << "Please specify --in_file=XXX or --webcam=true\n";
+  bool batch = !FLAG_inDir.empty() || !FLAG_inList.empty();
+  if (FLAG_inFile.empty() && !FLAG_webcam && !batch) {
+    std::cerr << "Please specify --in_file=XXX, --in_dir=XXX, --in_list=XXX or --webcam=true\n";
     ++nErrs;
   }
-  if (FLAG_outFile.empty() && !FLAG_show) {
-    std::cerr << "Please specify --out_file=XXX or --show\n";
+  if (batch ? (FLAG_outDir.empty() && !FLAG_show) : (FLAG_outFile.empty() && !FLAG_show)) {
+    std::cerr << (batch ? "Please specify --out_dir=XXX or --show\n" : "Please specify --out_file=XXX or --show\n");
     ++nErrs;
   }
   if (FLAG_effect.empty()) {
     std::cerr << "Please specify --effect=XXX\n";
     ++nErrs;
   }
+  if (FLAG_replay && (FLAG_webcam || FLAG_inFile.empty())) {
+    std::cerr << "--replay requires --in_file=XXX, and not --webcam\n";
+    ++nErrs;
+  }
+  if (!FLAG_renditions.empty()) {
+    std::vector<int> heights;
+    if (!ParseHeights(FLAG_renditions, &heights) || FLAG_outFile.empty() || batch ||
+        IsImageFile(FLAG_inFile.c_str())) {
+      std::cerr << "--renditions requires a list of heights, a video and --out_file=XXX\n";
+      ++nErrs;
+    } else {
+      FLAG_resolution = heights[0];  // The effect runs at the largest rendition
+    }
+  }
+  if (FLAG_segments > 1 &&
+      (FLAG_webcam || FLAG_replay || batch || FLAG_outFile.empty() || !FLAG_renditions.empty() ||
+       IsImageFile(FLAG_inFile.c_str()) || !EffectIsStateless(FLAG_effect.c_str()))) {
+    std::cerr << "--segments requires a video file, --out_file=XXX, and a stateless effect (Transfer, Upscale, "
+                 "SuperRes); it cannot be combined with --webcam, --replay or --renditions\n";
+    ++nErrs;
+  }
+  if (!FLAG_adaptiveRes.empty()) {
+    if (!ParseHeights(FLAG_adaptiveRes, &app._rungHeights) || batch || IsImageFile(FLAG_inFile.c_str()) ||
+        FLAG_pipeline || FLAG_segments > 1) {
+      std::cerr << "--adaptive_res requires a list of heights and a video or webcam; it cannot be combined with "
+                   "--pipeline or --segments\n";
+      ++nErrs;
+    }
+    std::reverse(app._rungHeights.begin(), app._rungHeights.end());  // Smallest first
+    app._rescaler = &rescaler;
+  }
+  if (FLAG_skipStatic && (FLAG_pipeline || FLAG_segments > 1)) {
+    std::cerr << "--skip_static cannot be combined with --pipeline or --segments\n";
+    ++nErrs;
+  }
+  if (FLAG_deadline &&
+      (FLAG_pipeline || FLAG_segments > 1 || (FLAG_lateFrames != "repeat" && FLAG_lateFrames != "pass"))) {
+    std::cerr << "--deadline cannot be combined with --pipeline or --segments, and --late_frames must be repeat or "
+                 "pass\n";
+    ++nErrs;
+  }
+  if (!FLAG_latencyCsv.empty()) FLAG_latency = true;
   app._progress = FLAG_progress;
   app.setShow(FLAG_show);
+  if (FLAG_latency) app._latency = &latency;
+  if (FLAG_deadline) app._scheduler = &scheduler;
+  if (FLAG_skipStatic) {
+    staticFrames.setThreshold(FLAG_staticThreshold);
+    app._staticFrames = &staticFrames;
+  }
 
   if (nErrs) {
     Usage();
     fxErr = FXApp::errFlag;
   } else {
-    fxErr = app.createEffect(FLAG_effect.c_str(), FLAG_modelDir.c_str());
+    if (FLAG_stubEffect)
+      fxErr = app.createStubEffect(FLAG_effect.c_str());
+    else
+      fxErr = app.createEffect(FLAG_effect.c_str(), FLAG_modelDir.c_str());
     if (FXApp::errNone != fxErr) {
       std::cerr << "Error creating effect \"" << FLAG_effect << "\"\n";
+    } else if (batch) {
+      std::vector<std::string> inFiles;
+      if (!GetImageFileList(&inFiles))
+        fxErr = FXApp::errRead;
+      else
+        fxErr = app.processImages(inFiles, FLAG_outDir.c_str());
     } else {
       if (IsImageFile(FLAG_inFile.c_str()))
         fxErr = app.processImage(FLAG_inFile.c_str(), FLAG_outFile.c_str());
+      else if (FLAG_segments > 1)
+        fxErr = app.processMovieSegmented(FLAG_inFile.c_str(), FLAG_outFile.c_str());
       else
         fxErr = app.processMovie(FLAG_inFile.c_str(), FLAG_outFile.c_str());
     }
   }
+  if (FLAG_deadline) scheduler.report(stdout);
+  if (FLAG_skipStatic) staticFrames.report(stdout);
+  if (app._rescaler) rescaler.report(stdout, app._rungHeights);
+  if (FLAG_latency) {
+    latency.report(stdout);
+    if (!FLAG_latencyCsv.empty() && !latency.writeCSV(FLAG_latencyCsv.c_str()))
+      printf("Error writing: \"%s\"\n", FLAG_latencyCsv.c_str());
+  }
 
   if (fxErr) std::cerr << "Error: " << app.errorStringFromCode(fxErr) << std::endl;
   return (int)fxErr;
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __ALLOC_COUNTER_H__
+#define __ALLOC_COUNTER_H__
+
+#include <atomic>
+
+#include "opencv2/opencv.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Counts the memory that OpenCV allocates for cv::Mat, so that a frame loop can be shown to    ///
+/// allocate nothing once it has reached its steady state. While installed, it is the default    ///
+/// allocator of every cv::Mat; it counts each allocation that is not of caller-provided memory, ///
+/// on any thread, and hands it to the allocator that it replaced, which also frees it. Read    ///
+/// the count before and after the frames of interest; the difference is what they allocated.  ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class AllocCounter : public cv::MatAllocator {
+ public:
+  AllocCounter() : m_base(nullptr), m_count(0) {}
+  ~AllocCounter() { uninstall(); }
+
+  /// Start counting.
+  void install() {
+    if (m_base) return;
+    m_base = cv::Mat::getDefaultAllocator();
+    cv::Mat::setDefaultAllocator(this);
+  }
+
+  /// Stop counting, restoring the allocator that was replaced.
+  void uninstall() {
+    if (!m_base) return;
+    cv::Mat::setDefaultAllocator(m_base);
+    m_base = nullptr;
+  }
+
+  /// Get the number of allocations counted so far.
+  unsigned long long count() const { return m_count.load(); }
+
+ private:
+  // The access flags are an int in OpenCV 3, and an enum in later versions; map() is not overloaded, so they are taken
+  // from its signature.
+  template <typename T>
+  struct SecondArg;
+  template <typename R, typename C, typename A1, typename A2>
+  struct SecondArg<R (C::*)(A1, A2) const> {
+    typedef A2 type;
+  };
+  typedef SecondArg<decltype(&cv::MatAllocator::map)>::type AccessFlags;
+
+  cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, AccessFlags flags,
+                         cv::UMatUsageFlags usageFlags) const override {
+    if (!data) ++m_count;
+    return m_base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+  }
+  bool allocate(cv::UMatData* data, AccessFlags flags, cv::UMatUsageFlags usageFlags) const override {
+    return m_base->allocate(data, flags, usageFlags);
+  }
+  void deallocate(cv::UMatData* data) const override { m_base->deallocate(data); }  // The base frees its own
+
+  cv::MatAllocator* m_base;                          ///< The allocator that was replaced, while installed.
+  mutable std::atomic<unsigned long long> m_count;  ///< The number of allocations.
+};
+
+#endif  // __ALLOC_COUNTER_H__
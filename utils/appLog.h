@@ -0,0 +1,138 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __APP_LOG_H__
+#define __APP_LOG_H__
+
+#include <stdarg.h>
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A header-only, level-filtered logging front end for the sample applications.                 ///
+///                                                                                              ///
+/// APP_LOG_LEVEL selects at build time the most verbose level that is compiled in. Messages     ///
+/// above that level expand to an empty statement, so their arguments are never evaluated, and  ///
+/// they can be left in frame loops at no cost. Messages at or below that level are filtered    ///
+/// again at run time by AppLogSetLevel(), and are delivered to a sink with the same signature  ///
+/// as the callbacks in nvCVLoggerExamples.h, e.g. AppLogSetSink(StderrLogger::Callback, &log). ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define APP_LOG_LEVEL_FATAL 0  // These match the --log_level numbering used by the SDK logger
+#define APP_LOG_LEVEL_ERROR 1
+#define APP_LOG_LEVEL_WARNING 2
+#define APP_LOG_LEVEL_INFO 3
+#define APP_LOG_LEVEL_DEBUG 4
+
+#ifndef APP_LOG_LEVEL
+#ifdef NDEBUG
+#define APP_LOG_LEVEL APP_LOG_LEVEL_INFO
+#else  // !NDEBUG
+#define APP_LOG_LEVEL APP_LOG_LEVEL_DEBUG
+#endif  // NDEBUG
+#endif  // APP_LOG_LEVEL
+
+/// The signature of a log sink; this is the same as the SDK logger callback.
+typedef void (*AppLogSink)(void* userData, const char* msg);
+
+/// The run-time logging configuration, shared by all translation units.
+struct AppLogConfig {
+  int level;          ///< The most verbose level that will be emitted at run time.
+  AppLogSink sink;    ///< The sink; NULL writes directly to stderr.
+  void* sinkData;     ///< The user data supplied to the sink.
+};
+
+/// Access the run-time logging configuration.
+/// @return a reference to the singleton configuration.
+inline AppLogConfig& AppLogGetConfig() {
+  static AppLogConfig config = {APP_LOG_LEVEL_WARNING, nullptr, nullptr};
+  return config;
+}
+
+/// Set the run-time log level. Levels above APP_LOG_LEVEL have been compiled out, so are silently clamped.
+/// @param[in]  level the most verbose level to be emitted.
+inline void AppLogSetLevel(int level) {
+  AppLogGetConfig().level = (level < APP_LOG_LEVEL) ? level : APP_LOG_LEVEL;
+}
+
+/// Set the sink for log messages.
+/// @param[in]  sink      the sink, e.g. StderrLogger::Callback, or NULL to write to stderr.
+/// @param[in]  sinkData  the user data for the sink, e.g. a pointer to the logger instance.
+inline void AppLogSetSink(AppLogSink sink, void* sinkData) {
+  AppLogGetConfig().sink = sink;
+  AppLogGetConfig().sinkData = sinkData;
+}
+
+/// Query whether a given level will be emitted at run time.
+/// @param[in]  level the level to be queried.
+/// @return     true  if messages at the given level would be emitted.
+inline bool AppLogEnabled(int level) { return level <= AppLogGetConfig().level; }
+
+/// Format a message and deliver it to the sink. This is normally called through the APP_LOG_* macros.
+/// @param[in]  level the level of the message, which is used to prefix the message.
+/// @param[in]  fmt   the printf-style format.
+inline void AppLogPrintf(int level, const char* fmt, ...) {
+  static const char* const prefix[] = {"FATAL: ", "ERROR: ", "WARNING: ", "", ""};
+  char buf[1024];
+  int n = snprintf(buf, sizeof(buf), "%s", prefix[(unsigned)level < 5u ? level : 4]);
+  va_list ap;
+  va_start(ap, fmt);
+  (void)vsnprintf(buf + n, sizeof(buf) - n, fmt, ap);  // Long messages are truncated
+  va_end(ap);
+  const AppLogConfig& config = AppLogGetConfig();
+  if (config.sink)
+    config.sink(config.sinkData, buf);
+  else
+    fputs(buf, stderr);
+}
+
+#define APP_LOG_AT(level, ...)                                \
+  do {                                                        \
+    if (AppLogEnabled(level)) AppLogPrintf(level, __VA_ARGS__); \
+  } while (0)
+#define APP_LOG_NOTHING(...) \
+  do {                       \
+  } while (0)
+
+#define APP_LOG_FATAL(...) APP_LOG_AT(APP_LOG_LEVEL_FATAL, __VA_ARGS__)
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_ERROR
+#define APP_LOG_ERROR(...) APP_LOG_AT(APP_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else  // APP_LOG_LEVEL < APP_LOG_LEVEL_ERROR
+#define APP_LOG_ERROR(...) APP_LOG_NOTHING(__VA_ARGS__)
+#endif  // APP_LOG_LEVEL
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_WARNING
+#define APP_LOG_WARNING(...) APP_LOG_AT(APP_LOG_LEVEL_WARNING, __VA_ARGS__)
+#else  // APP_LOG_LEVEL < APP_LOG_LEVEL_WARNING
+#define APP_LOG_WARNING(...) APP_LOG_NOTHING(__VA_ARGS__)
+#endif  // APP_LOG_LEVEL
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_INFO
+#define APP_LOG_INFO(...) APP_LOG_AT(APP_LOG_LEVEL_INFO, __VA_ARGS__)
+#else  // APP_LOG_LEVEL < APP_LOG_LEVEL_INFO
+#define APP_LOG_INFO(...) APP_LOG_NOTHING(__VA_ARGS__)
+#endif  // APP_LOG_LEVEL
+#if APP_LOG_LEVEL >= APP_LOG_LEVEL_DEBUG
+#define APP_LOG_DEBUG(...) APP_LOG_AT(APP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else  // APP_LOG_LEVEL < APP_LOG_LEVEL_DEBUG
+#define APP_LOG_DEBUG(...) APP_LOG_NOTHING(__VA_ARGS__)
+#endif  // APP_LOG_LEVEL
+
+#endif  // __APP_LOG_H__
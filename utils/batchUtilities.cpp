@@ -33,6 +33,16 @@ NvCV_Status AllocateBatchBuffer(NvCVImage* im, unsigned batchSize, unsigned widt
   return NvCVImage_Alloc(im, width, height * batchSize, format, type, layout, memSpace, alignment);
 }
 
+/********************************************************************************
+ * ReallocateBatchBuffer
+ ********************************************************************************/
+
+NvCV_Status ReallocateBatchBuffer(NvCVImage* im, unsigned batchSize, unsigned width, unsigned height,
+                                  NvCVImage_PixelFormat format, NvCVImage_ComponentType type, unsigned layout,
+                                  unsigned memSpace, unsigned alignment) {
+  return NvCVImage_Realloc(im, width, height * batchSize, format, type, layout, memSpace, alignment);
+}
+
 /********************************************************************************
  * NthImage
  ********************************************************************************/
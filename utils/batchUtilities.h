@@ -48,6 +48,25 @@ NvCV_Status AllocateBatchBuffer(NvCVImage* im, unsigned batchSize, unsigned widt
                                 NvCVImage_PixelFormat format, NvCVImage_ComponentType type, unsigned layout,
                                 unsigned memSpace, unsigned alignment);
 
+//! Reallocate a batch buffer, reusing the existing memory if it is large enough.
+//! \note All of the arguments are identical to that of NvCVImage_Realloc plus the batchSize.
+//! \param[in,out] im        the image to reshape.
+//! \param[in]     batchSize the number of images in the batch.
+//! \param[in]     width     the desired width  of each image, in pixels.
+//! \param[in]     height    the desired height of each image, in pixels.
+//! \param[in]     format    the format of the pixels.
+//! \param[in]     type      the type of the components of the pixels.
+//! \param[in]     layout    One of { NVCV_CHUNKY, NVCV_PLANAR } or one of the YUV layouts.
+//! \param[in]     memSpace  Location of the buffer: one of { NVCV_CPU, NVCV_CPU_PINNED, NVCV_GPU, NVCV_CUDA }
+//! \param[in]     alignment row byte alignment. Choose 0 or a power of 2.
+//! \return NVCV_SUCCESS         if the operation was successful.
+//! \return NVCV_ERR_PIXELFORMAT if the pixel format is not accommodated.
+//! \return NVCV_ERR_MEMORY      if there is not enough memory to allocate the buffer.
+//! \note   this simply multiplies height by batchSize and calls NvCVImage_Realloc().
+NvCV_Status ReallocateBatchBuffer(NvCVImage* im, unsigned batchSize, unsigned width, unsigned height,
+                                  NvCVImage_PixelFormat format, NvCVImage_ComponentType type, unsigned layout,
+                                  unsigned memSpace, unsigned alignment);
+
 //! Initialize an image descriptor for the Nth image in a batch.
 //! \param[in]  n       the index of the desired image in the batch.
 //! \param[in]  height  the height of the image
@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __BUFFER_PLANNER_H__
+#define __BUFFER_PLANNER_H__
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Packs the buffers of a pipeline into one arena, so that buffers that are never live at the   ///
+/// same time share memory. A frame is processed as a sequence of steps, all in stream order,    ///
+/// and each buffer is live from the step that first writes it to the step that last reads it,  ///
+/// inclusive; a buffer that must survive from one frame to the next is live for every step.   ///
+/// Buffers are placed from the largest to the smallest, each at the lowest offset that does not ///
+/// overlap a buffer placed before it whose lifetime overlaps its own. The arena is the peak     ///
+/// that the pipeline needs, which is compared with the sum of the buffers, as they would be     ///
+/// allocated separately.                                                                        ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class BufferPlanner {
+ public:
+  BufferPlanner() : m_arenaBytes(0) {}
+
+  /// Add a buffer to the plan.
+  /// @param[in]  bytes      the size of the buffer.
+  /// @param[in]  firstStep  the step that first writes it.
+  /// @param[in]  lastStep   the step that last reads it.
+  /// @return     the index of the buffer, by which its offset is retrieved.
+  unsigned add(size_t bytes, unsigned firstStep, unsigned lastStep) {
+    Buffer b = {bytes, firstStep, lastStep, 0};
+    m_buffers.push_back(b);
+    return (unsigned)m_buffers.size() - 1;
+  }
+
+  /// Assign an offset in the arena to every buffer.
+  /// @param[in]  alignment  the alignment of every offset, a power of 2.
+  /// @return     the size of the arena.
+  size_t plan(size_t alignment) {
+    std::vector<unsigned> order(m_buffers.size()), placed;
+    for (unsigned i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [this](unsigned a, unsigned b) { return m_buffers[a].bytes > m_buffers[b].bytes; });
+    m_arenaBytes = 0;
+    for (unsigned i : order) {
+      Buffer& b = m_buffers[i];
+      std::vector<unsigned> live;  // The buffers already placed that are live at the same time, by offset
+      for (unsigned j : placed)
+        if (b.firstStep <= m_buffers[j].lastStep && m_buffers[j].firstStep <= b.lastStep) live.push_back(j);
+      std::sort(live.begin(), live.end(),
+                [this](unsigned a, unsigned b) { return m_buffers[a].offset < m_buffers[b].offset; });
+      b.offset = 0;
+      for (unsigned j : live) {  // Find the first gap that is large enough
+        if (b.offset + b.bytes <= m_buffers[j].offset) break;
+        b.offset = std::max(b.offset, (m_buffers[j].offset + m_buffers[j].bytes + alignment - 1) & ~(alignment - 1));
+      }
+      m_arenaBytes = std::max(m_arenaBytes, b.offset + b.bytes);
+      placed.push_back(i);
+    }
+    return m_arenaBytes;
+  }
+
+  /// Get the offset of a buffer in the arena, after plan().
+  size_t offset(unsigned i) const { return m_buffers[i].offset; }
+
+  /// Get the size of the arena, after plan().
+  size_t arenaBytes() const { return m_arenaBytes; }
+
+  /// Get the memory that the buffers would take if each were allocated separately.
+  size_t separateBytes() const {
+    size_t bytes = 0;
+    for (const Buffer& b : m_buffers) bytes += b.bytes;
+    return bytes;
+  }
+
+  /// Remove every buffer.
+  void clear() {
+    m_buffers.clear();
+    m_arenaBytes = 0;
+  }
+
+ private:
+  struct Buffer {
+    size_t bytes;        ///< The size of the buffer.
+    unsigned firstStep;  ///< The first step at which it is live.
+    unsigned lastStep;   ///< The last step at which it is live.
+    size_t offset;       ///< Its offset in the arena.
+  };
+  std::vector<Buffer> m_buffers;  ///< The buffers, in the order that they were added.
+  size_t m_arenaBytes;            ///< The size of the arena.
+};
+
+#endif  // __BUFFER_PLANNER_H__
@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CASCADE_PLANNER_H__
+#define __CASCADE_PLANNER_H__
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Chooses the cheapest cascade of scaling effects that takes frames from one height to         ///
+/// another, e.g. SuperRes 720p --> 1440p, then Upscale 1440p --> 2160p, rather than Upscale     ///
+/// alone. Each candidate is one or two stages; an effect with fixed scales runs only at 4/3x,   ///
+/// 1.5x, 2x, 3x or 4x, and any other runs at up to 4x. The time that each stage takes is        ///
+/// measured on the local GPU, the first time that it is needed, and cached in a text file, one  ///
+/// stage per line, so later runs plan without measuring. A stage is keyed by its size and by    ///
+/// the settings of its effect that change its cost, such as its precision and mode, so a table  ///
+/// measured with other settings is not reused for them. A stage that could not be loaded is     ///
+/// cached as infeasible. The quality tier limits the candidates by how much of the scaling is   ///
+/// done by the effects marked as high quality.                                                  ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CascadePlanner {
+ public:
+  enum Quality {
+    fast,      ///< The cheapest cascade.
+    balanced,  ///< The cheapest in which high-quality effects do at least half of the scaling, where possible.
+    best,      ///< The cheapest in which high-quality effects do as much of the scaling as they can.
+  };
+  struct Stage {
+    std::string effect;    ///< The name of the effect.
+    std::string settings;  ///< The settings of the effect that change its cost.
+    unsigned inWidth, inHeight;
+    unsigned outHeight;  ///< The output width keeps the aspect ratio, rounded down.
+  };
+  struct Plan {
+    std::vector<Stage> stages;  ///< The stages, in the order that they are run.
+    double ms;                  ///< The time that the stages take, per frame.
+    double hqFraction;          ///< The fraction of the scaling, by its logarithm, done by high-quality effects.
+  };
+  /// Measures a stage, returning the time per frame in milliseconds, or a negative number if it cannot be run.
+  typedef std::function<double(const Stage&)> Measure;
+
+  CascadePlanner() : m_dirty(false) {}
+
+  /// Make an effect available to the cascades.
+  /// @param[in]  name         the name of the effect.
+  /// @param[in]  fixedScales  true if the effect only scales by 4/3, 1.5, 2, 3 or 4; false if by any factor up to 4.
+  /// @param[in]  highQuality  true if the scaling that the effect does counts towards the quality tier.
+  /// @param[in]  settings     the settings of the effect that change its cost, as one word, e.g. "f16,mode=1".
+  void addEffect(const char* name, bool fixedScales, bool highQuality, const char* settings) {
+    Effect e = {name, (settings && *settings) ? settings : "-", fixedScales, highQuality};
+    m_effects.push_back(e);
+  }
+
+  /// Read the cost table. A missing file, or one in an older format, is an empty table.
+  /// @param[in]  file  the path of the file.
+  void loadCosts(const char* file) {
+    char line[192], name[64], settings[64];
+    unsigned inW, inH, outH;
+    double ms;
+    FILE* fd = fopen(file, "r");
+    if (!fd) return;
+    if (fgets(line, sizeof(line), fd) && !strcmp(line, Header()))  // Else it is measured afresh, and overwritten
+      while (fgets(line, sizeof(line), fd))                         // Lines that do not parse are ignored
+        if (6 == sscanf(line, "%63s %63s %u %u %u %lf", name, settings, &inW, &inH, &outH, &ms))
+          m_costs[Key(name, settings, inW, inH, outH)] = ms;
+    fclose(fd);
+    m_dirty = false;
+  }
+
+  /// Write the cost table, if any stage has been measured since it was read.
+  /// @param[in]  file  the path of the file.
+  /// @return     true  if the table was written or did not need to be.
+  bool saveCosts(const char* file) const {
+    if (!m_dirty) return true;
+    FILE* fd = fopen(file, "w");
+    if (!fd) return false;
+    fputs(Header(), fd);
+    for (const std::pair<const std::string, double>& c : m_costs) fprintf(fd, "%s %.4f\n", c.first.c_str(), c.second);
+    return 0 == fclose(fd);
+  }
+
+  /// Choose the cheapest cascade that meets a quality tier.
+  /// @param[in]  width    the width of the input frames.
+  /// @param[in]  height   the height of the input frames.
+  /// @param[in]  target   the height of the output frames, greater than the input height.
+  /// @param[in]  quality  the quality tier.
+  /// @param[in]  measure  the function that measures a stage that is not in the cost table.
+  /// @param[out] plan     the cascade.
+  /// @return     true     if a cascade was found.
+  bool plan(unsigned width, unsigned height, unsigned target, Quality quality, const Measure& measure, Plan* plan) {
+    std::vector<Plan> feasible;
+    double maxHq = 0., minHq;
+    m_candidates.clear();
+    if (target <= height) return false;
+    for (const Effect& a : m_effects) {
+      addCandidate({{a, height, target}}, width);
+      for (const Effect& b : m_effects) {  // a to an intermediate height, then b to the target
+        if (!a.fixedScales && !b.fixedScales) continue;  // Either could do it in one stage
+        for (unsigned i = 0; i < numScales; ++i) {
+          const Ratio& r = Scales()[i];
+          if (a.fixedScales && 0 == height * r.num % r.den)
+            addCandidate({{a, height, height * r.num / r.den}, {b, height * r.num / r.den, target}}, width);
+          if (b.fixedScales && !a.fixedScales && 0 == target * r.den % r.num)
+            addCandidate({{a, height, target * r.den / r.num}, {b, target * r.den / r.num, target}}, width);
+        }
+      }
+    }
+    for (Plan& p : m_candidates) {
+      p.ms = 0.;
+      for (const Stage& s : p.stages) {
+        double ms = cost(s, measure);
+        if (ms < 0.) {
+          p.ms = -1.;
+          break;
+        }
+        p.ms += ms;
+      }
+      if (p.ms < 0.) continue;
+      feasible.push_back(p);
+      if (maxHq < p.hqFraction) maxHq = p.hqFraction;
+    }
+    switch (quality) {
+      case fast: minHq = 0.; break;
+      case balanced: minHq = (maxHq < .5) ? maxHq : .5; break;
+      default: minHq = maxHq; break;
+    }
+    const Plan* cheapest = nullptr;
+    for (const Plan& p : feasible)
+      if (p.hqFraction >= minHq - 1e-6 &&
+          (!cheapest || p.ms < cheapest->ms || (p.ms == cheapest->ms && p.stages.size() < cheapest->stages.size())))
+        cheapest = &p;
+    if (!cheapest) return false;
+    *plan = *cheapest;
+    return true;
+  }
+
+  /// Get every cascade that was considered by the last plan(), with its cost, or -1 if it cannot be run.
+  const std::vector<Plan>& candidates() const { return m_candidates; }
+
+ private:
+  struct Effect {
+    std::string name;
+    std::string settings;
+    bool fixedScales;
+    bool highQuality;
+  };
+  struct Ratio {
+    unsigned num, den;
+  };
+  struct Step {
+    const Effect& effect;
+    unsigned inHeight, outHeight;
+  };
+  enum { numScales = 5 };
+
+  static const Ratio* Scales() {
+    static const Ratio scales[numScales] = {{4, 3}, {3, 2}, {2, 1}, {3, 1}, {4, 1}};
+    return scales;
+  }
+
+  // The first line of the cost table, which names its columns; a table with another first line is not read.
+  static const char* Header() {
+    return "# effect settings inWidth inHeight outHeight ms, measured on this machine; -1 if the stage cannot be run\n";
+  }
+
+  static std::string Key(const std::string& name, const std::string& settings, unsigned inW, unsigned inH,
+                         unsigned outH) {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%s %s %u %u %u", name.c_str(), settings.c_str(), inW, inH, outH);
+    return buf;
+  }
+
+  static bool IsFixedScale(unsigned inHeight, unsigned outHeight) {
+    for (unsigned i = 0; i < numScales; ++i)
+      if (inHeight * Scales()[i].num == outHeight * Scales()[i].den) return true;
+    return false;
+  }
+
+  // Add a cascade whose every stage scales up by no more than 4x, at a scale that its effect supports.
+  void addCandidate(const std::vector<Step>& steps, unsigned width) {
+    Plan p;
+    double hq = 0., total = 0.;
+    for (const Step& st : steps) {
+      if (st.outHeight <= st.inHeight || st.outHeight > 4 * st.inHeight) return;
+      if (st.effect.fixedScales && !IsFixedScale(st.inHeight, st.outHeight)) return;
+      Stage s = {st.effect.name, st.effect.settings, width, st.inHeight, st.outHeight};
+      p.stages.push_back(s);
+      double lg = log((double)st.outHeight / st.inHeight);
+      total += lg;
+      if (st.effect.highQuality) hq += lg;
+      width = width * st.outHeight / st.inHeight;
+    }
+    p.ms = -1.;
+    p.hqFraction = hq / total;
+    m_candidates.push_back(p);
+  }
+
+  double cost(const Stage& s, const Measure& measure) {
+    std::string key = Key(s.effect, s.settings, s.inWidth, s.inHeight, s.outHeight);
+    std::map<std::string, double>::const_iterator it = m_costs.find(key);
+    if (it != m_costs.end()) return it->second;
+    double ms = measure(s);
+    m_costs[key] = (ms < 0.) ? -1. : ms;
+    m_dirty = true;
+    return m_costs[key];
+  }
+
+  std::vector<Effect> m_effects;          ///< The effects that can be used.
+  std::map<std::string, double> m_costs;  ///< The time per frame of each stage, keyed by effect, settings and size.
+  std::vector<Plan> m_candidates;         ///< The cascades considered by the last plan().
+  bool m_dirty;                           ///< A stage has been measured since the table was read.
+};
+
+#endif  // __CASCADE_PLANNER_H__
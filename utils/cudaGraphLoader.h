@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CUDA_GRAPH_LOADER_H__
+#define __CUDA_GRAPH_LOADER_H__
+
+#include "appLog.h"
+#include "nvVideoEffects.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Loads an effect so that it replays its kernels from a CUDA graph, which removes most of the  ///
+/// per-frame launch overhead at small resolutions. A graph is captured for the images that are  ///
+/// bound, so an app that alternates frames between two sets of GPU buffers binds only one set   ///
+/// to a graphed effect. That is safe in stream order, since frame k-1 is downloaded before      ///
+/// frame k is run. If the effect does not support graphs, or cannot be loaded with one, a       ///
+/// warning is logged and it is loaded to launch its kernels individually.                       ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CudaGraphLoader {
+ public:
+  /// Load an effect, with a CUDA graph if requested and possible.
+  /// @param[in]  eff        the effect, with its images and parameters set.
+  /// @param[in]  name       the name of the effect, for the warnings.
+  /// @param[in]  cudaGraph  true to load the effect with a CUDA graph, if it can be.
+  /// @param[out] graphed    set to true if the effect was loaded with a CUDA graph; may be null.
+  /// @return     the status of NvVFX_Load().
+  static NvCV_Status Load(NvVFX_Handle eff, const char* name, bool cudaGraph, bool* graphed) {
+    NvCV_Status vfxErr;
+    bool graph = cudaGraph && (NVCV_SUCCESS == NvVFX_SetU32(eff, NVVFX_CUDA_GRAPH, 1u));
+    if (cudaGraph && !graph) APP_LOG_WARNING("%s does not support CUDA graphs\n", name);
+    vfxErr = NvVFX_Load(eff);
+    if (NVCV_SUCCESS != vfxErr && graph) {
+      APP_LOG_WARNING("%s could not be loaded with a CUDA graph: %s\n", name, NvCV_GetErrorStringFromCode(vfxErr));
+      NvVFX_SetU32(eff, NVVFX_CUDA_GRAPH, 0u);
+      graph = false;
+      vfxErr = NvVFX_Load(eff);
+    }
+    if (graphed) *graphed = graph;
+    return vfxErr;
+  }
+};
+
+#endif  // __CUDA_GRAPH_LOADER_H__
@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __DEADLINE_SCHEDULER_H__
+#define __DEADLINE_SCHEDULER_H__
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Decides, frame by frame, whether there is still time to apply an effect, so that real-time  ///
+/// output keeps pace with its source instead of drifting further behind. Each frame is due a   ///
+/// fixed budget after its scheduled time: for a live source, the time at which it was          ///
+/// captured; for a file, the time at which it would be played. A caller that overlaps frames   ///
+/// outputs each one a fixed number of frames after it is run, and that delay is added to the   ///
+/// deadline, so the budget only covers processing. The time that the caller measures for       ///
+/// processing a frame is tracked as a moving average, and a frame that would not be processed  ///
+/// by its deadline is skipped, so that the caller can repeat the last output or pass it        ///
+/// through. The estimate decays while frames are skipped, so that a frame is admitted again    ///
+/// from time to time, to measure it afresh. It is not thread-safe.                             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class DeadlineScheduler {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  DeadlineScheduler() { start(30., 1., false, 0); }
+
+  /// Start scheduling a stream.
+  /// @param[in]  frameRate     the frame rate of the source.
+  /// @param[in]  budgetFrames  the time allowed for processing each frame, from its scheduled time, in frames.
+  /// @param[in]  live          true if the frames are scheduled by their capture time, false if by their frame number.
+  /// @param[in]  depth         the number of frames after which a processed frame is output, e.g. 1 if frame k-1 is
+  ///                           output while frame k is processed.
+  void start(double frameRate, double budgetFrames, bool live, unsigned depth) {
+    m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1. / frameRate));
+    m_budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(budgetFrames / frameRate));
+    m_delay = depth * m_period;
+    m_live = live;
+    m_started = false;
+    m_cost = Clock::duration::zero();
+    m_processed = m_skipped = m_missed = 0;
+    m_maxLate = Clock::duration::zero();
+    for (Slot& s : m_slots) s.skipped = true;  // Until admitted
+  }
+
+  /// Decide whether a frame should be processed.
+  /// @param[in]  frameNum     the number of the frame.
+  /// @param[in]  captureTime  the time at which the frame was captured, or read.
+  /// @return     true         if the frame can be processed by its deadline; false if it should be skipped.
+  bool admit(unsigned frameNum, Clock::time_point captureTime) {
+    Clock::time_point now = Clock::now();
+    if (!m_started) {  // A file's schedule starts with its first frame
+      m_start = captureTime - frameNum * m_period;
+      m_started = true;
+    }
+    Slot& s = m_slots[frameNum % numSlots];
+    s.due = (m_live ? captureTime : m_start + frameNum * m_period) + m_budget + m_delay;
+    s.skipped = (now + m_cost + m_delay > s.due);
+    if (s.skipped) {
+      m_cost -= m_cost / 8;  // Else a frame that was once slow would keep every later frame from being measured
+      ++m_skipped;
+      return false;
+    }
+    ++m_processed;
+    return true;
+  }
+
+  /// Refine the estimate of the time that processing a frame takes, e.g. uploading it, running the effect and
+  /// downloading it, but not waiting for the next frame, nor encoding or displaying it.
+  /// @param[in]  took  the time that processing an admitted frame took.
+  void measured(Clock::duration took) {
+    m_cost = (m_cost == Clock::duration::zero()) ? took : (7 * m_cost + took) / 8;  // Exponential moving average
+  }
+
+  /// Record that a frame has been output, to count the admitted frames that were output after their deadline; a
+  /// skipped frame is ignored.
+  /// @param[in]  frameNum  the number of the frame.
+  void finished(unsigned frameNum) {
+    Clock::time_point now = Clock::now();
+    const Slot& s = m_slots[frameNum % numSlots];
+    if (s.skipped) return;
+    if (now > s.due) {
+      ++m_missed;
+      m_maxLate = std::max(m_maxLate, now - s.due);
+    }
+  }
+
+  /// Print the number of frames processed, skipped, and processed but late.
+  /// @param[in]  fd  the file to print to.
+  void report(FILE* fd) const {
+    unsigned total = m_processed + m_skipped;
+    fprintf(fd, "%u of %u frames skipped (%.1f%%), %u processed late (by up to %.1f ms); %.1f ms per frame\n",
+            m_skipped, total, (total ? 100. * m_skipped / total : 0.), m_missed,
+            std::chrono::duration<double, std::milli>(m_maxLate).count(),
+            std::chrono::duration<double, std::milli>(m_cost).count());
+  }
+
+  unsigned processed() const { return m_processed; }
+  unsigned skipped() const { return m_skipped; }
+
+ private:
+  enum { numSlots = 4 };  ///< More than the number of frames in flight.
+  struct Slot {
+    Clock::time_point due;  ///< The time by which the frame should be output.
+    bool skipped;           ///< The frame was not admitted.
+  };
+  Clock::duration m_period;   ///< The frame period.
+  Clock::duration m_budget;   ///< The time allowed for processing a frame, from its scheduled time.
+  Clock::duration m_delay;    ///< The time from processing a frame until it is output, in whole frame periods.
+  Clock::duration m_cost;     ///< The moving average of the time that processing a frame takes.
+  Clock::duration m_maxLate;  ///< The most that a processed frame has missed its deadline by.
+  Clock::time_point m_start;  ///< The scheduled time of frame 0 of a file.
+  bool m_live;                ///< Frames are scheduled by their capture time.
+  bool m_started;             ///< A frame has been admitted.
+  unsigned m_processed;       ///< The number of frames admitted.
+  unsigned m_skipped;         ///< The number of frames skipped.
+  unsigned m_missed;          ///< The number of admitted frames that were output after their deadline.
+  Slot m_slots[numSlots];     ///< The deadlines of the most recent frames.
+};
+
+#endif  // __DEADLINE_SCHEDULER_H__
@@ -0,0 +1,276 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2020-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "effectChain.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "appLog.h"
+#include "cudaGraphLoader.h"
+
+#define BAIL_IF_ERR(err) \
+  do {                   \
+    if (0 != (err)) {    \
+      goto bail;         \
+    }                    \
+  } while (0)
+
+// The value of white in a component type: NVCV_U8 images are in [0, 255], and NVCV_F16 and NVCV_F32 images in [0, 1].
+static float White(NvCVImage_ComponentType type) { return (NVCV_U8 == type) ? 255.f : 1.f; }
+
+// Whether two effects can share a buffer; they may differ in the alignment that they require.
+static bool SameFormat(const EffectChain::Format& a, const EffectChain::Format& b) {
+  return a.pixelFormat == b.pixelFormat && a.componentType == b.componentType && a.layout == b.layout;
+}
+
+static const char* FormatString(const EffectChain::Format& f) {
+  static char buf[32];
+  snprintf(buf, sizeof(buf), "%s %s %s",
+           (NVCV_RGBA == f.pixelFormat ? "RGBA" : NVCV_BGR == f.pixelFormat ? "BGR" : "?"),
+           (NVCV_F32 == f.componentType ? "F32" : NVCV_F16 == f.componentType ? "F16" : "U8"),
+           (NVCV_PLANAR == f.layout ? "planar" : "chunky"));
+  return buf;
+}
+
+/********************************************************************************
+ * EffectChain
+ ********************************************************************************/
+
+EffectChain::EffectChain() : m_stream(nullptr), m_numBufs(2), m_outWidth(0), m_outHeight(0), m_numConversions(0) {}
+
+EffectChain::~EffectChain() { destroy(); }
+
+NvCV_Status EffectChain::addStage(const char* selector, const Format& format, unsigned outHeight, bool stateful) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  std::unique_ptr<Stage> s(new Stage);
+  s->name = selector;
+  s->eff = nullptr;
+  s->format = s->active = format;
+  s->half = false;
+  s->outHeight = outHeight;
+  s->stateful = stateful;
+  s->state = nullptr;
+  s->in[0] = s->in[1] = s->out[0] = s->out[1] = nullptr;
+  s->convertFrom = nullptr;
+  s->convertScale = 1.f;
+  s->boundIn = s->boundOut = nullptr;
+  if (!m_stream) BAIL_IF_ERR(vfxErr = NvVFX_CudaStreamCreate(&m_stream));
+  BAIL_IF_ERR(vfxErr = NvVFX_CreateEffect(selector, &s->eff));
+  BAIL_IF_ERR(vfxErr = NvVFX_SetCudaStream(s->eff, NVVFX_CUDA_STREAM, m_stream));
+  m_stages.push_back(std::move(s));
+bail:
+  if (NVCV_SUCCESS != vfxErr && s && s->eff) NvVFX_DestroyEffect(s->eff);
+  return vfxErr;
+}
+
+// Declare a buffer, which is live from one step of a frame to another, inclusive. Its memory is assigned by
+// allocBuffers(), once every buffer has been declared.
+NvCVImage* EffectChain::newBuffer(unsigned width, unsigned height, const Format& format, unsigned alignment,
+                                  unsigned firstStep, unsigned lastStep) {
+  std::unique_ptr<Buffer> b(new Buffer);
+  unsigned numComponents = (NVCV_RGBA == format.pixelFormat || NVCV_BGRA == format.pixelFormat) ? 4 : 3;
+  unsigned componentBytes = (NVCV_F32 == format.componentType) ? 4 : (NVCV_F16 == format.componentType) ? 2 : 1;
+  size_t rowBytes = (size_t)width * componentBytes * (NVCV_PLANAR == format.layout ? 1 : numComponents);
+  if (!alignment) alignment = arenaAlignment;
+  b->width = width;
+  b->height = height;
+  b->format = format;
+  b->pitch = (int)((rowBytes + alignment - 1) / alignment * alignment);
+  b->index = m_planner.add((size_t)b->pitch * height * (NVCV_PLANAR == format.layout ? numComponents : 1), firstStep,
+                           lastStep);
+  m_buffers.push_back(std::move(b));
+  return &m_buffers.back()->image;
+}
+
+// Allocate one arena for all of the buffers, laid out so that buffers whose lifetimes do not overlap share memory.
+NvCV_Status EffectChain::allocBuffers() {
+  NvCV_Status vfxErr;
+  size_t bytes = m_planner.plan(arenaAlignment);
+  vfxErr = NvCVImage_Realloc(&m_arena, arenaAlignment, (unsigned)((bytes + arenaAlignment - 1) / arenaAlignment),
+                             NVCV_Y, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 1);
+  if (NVCV_SUCCESS != vfxErr) return vfxErr;
+  for (std::unique_ptr<Buffer>& b : m_buffers) {
+    vfxErr = NvCVImage_Init(&b->image, b->width, b->height, b->pitch,
+                            (unsigned char*)m_arena.pixels + m_planner.offset(b->index), b->format.pixelFormat,
+                            b->format.componentType, b->format.layout, NVCV_GPU);
+    if (NVCV_SUCCESS != vfxErr) return vfxErr;
+  }
+  return NVCV_SUCCESS;
+}
+
+// Load an effect, replaying its kernels from a CUDA graph if requested and supported.
+NvCV_Status EffectChain::loadStage(Stage& s, bool cudaGraph) {
+  return CudaGraphLoader::Load(s.eff, s.name.c_str(), cudaGraph, nullptr);
+}
+
+// Effects that take F32 images are first tried with F16 images, if requested. An effect that rejects them when its
+// images are set or when it is loaded is given F32 images instead, as are its neighbors in the same format, which would
+// otherwise need conversions to and from it; then the whole chain is laid out again, since that changes which buffers
+// can be shared.
+NvCV_Status EffectChain::load(unsigned width, unsigned height, bool cudaGraph, bool halfPrecision) {
+  NvCV_Status vfxErr;
+  for (std::unique_ptr<Stage>& s : m_stages) s->half = halfPrecision && NVCV_F32 == s->format.componentType;
+  for (;;) {
+    int failed = -1, i;
+    vfxErr = loadStages(width, height, cudaGraph, &failed);
+    if (NVCV_SUCCESS == vfxErr || failed < 0 || !m_stages[failed]->half) return vfxErr;
+    APP_LOG_WARNING("%s does not accept F16 images, so it will use F32: %s\n", m_stages[failed]->name.c_str(),
+                    NvCV_GetErrorStringFromCode(vfxErr));
+    const Format& f = m_stages[failed]->format;
+    for (i = failed; i >= 0 && SameFormat(m_stages[i]->format, f); --i) m_stages[i]->half = false;
+    for (i = failed + 1; i < (int)m_stages.size() && SameFormat(m_stages[i]->format, f); ++i) m_stages[i]->half = false;
+  }
+}
+
+// The buffers are negotiated from the first effect to the last. The output of each effect but the last is allocated
+// in its own format, with the alignment that both it and the next effect require if they share it; otherwise, the next
+// effect gets an input buffer of its own, and a conversion from the previous output. A graph is captured for the
+// buffers that are bound, so with graphs there is only one set of buffers.
+NvCV_Status EffectChain::loadStages(unsigned width, unsigned height, bool cudaGraph, int* failed) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  unsigned w = width, h = height, b, n = (unsigned)m_stages.size(), i;
+  char buf[128];
+
+  if (m_stages.empty()) return NVCV_ERR_EFFECT;
+  m_buffers.clear();
+  m_planner.clear();
+  for (std::unique_ptr<Stage>& s : m_stages) {
+    s->in[0] = s->in[1] = s->out[0] = s->out[1] = nullptr;
+    s->convertFrom = nullptr;
+    s->active = s->format;
+    if (s->half) s->active.componentType = NVCV_F16;
+  }
+  m_numBufs = cudaGraph ? 1 : 2;
+  m_numConversions = 0;
+  snprintf(buf, sizeof(buf), "upload %ux%u", w, h);
+  m_plan = buf;
+
+  // Each frame is a sequence of steps, in stream order: the upload is step 0; the conversion into stage i, if any, is
+  // step 2i+1, and its run step 2i+2; and the download is step 2n+1. The last output of one frame is only downloaded
+  // after the next frame has been uploaded, so it is live throughout.
+  for (i = 0; i < n; ++i) {
+    Stage& s = *m_stages[i];
+    Stage* next = (i + 1 < n) ? m_stages[i + 1].get() : nullptr;
+    if (i == 0) {  // The first input is uploaded into
+      for (b = 0; b < 2; ++b) s.in[b] = (b < m_numBufs) ? newBuffer(w, h, s.active, s.active.alignment, 0, 2) : s.in[0];
+    } else if (!s.in[0]) {  // Not shared with the previous output, which is converted into this input
+      const Stage& prev = *m_stages[i - 1];
+      s.in[0] = s.in[1] = newBuffer(w, h, s.active, s.active.alignment, 2 * i + 1, 2 * i + 2);
+      s.convertFrom = prev.out[0];
+      s.convertScale = White(s.active.componentType) / White(prev.active.componentType);
+      ++m_numConversions;
+      m_plan += " -> convert to ";
+      m_plan += FormatString(s.active);
+    }
+    if (s.outHeight) {
+      w = w * s.outHeight / h;
+      h = s.outHeight;
+    }
+    if (!next) {  // The last output is downloaded from
+      for (b = 0; b < 2; ++b)
+        s.out[b] = (b < m_numBufs) ? newBuffer(w, h, s.active, s.active.alignment, 0, 2 * n + 1) : s.out[0];
+    } else if (SameFormat(s.active, next->active)) {  // Shared with the next input
+      s.out[0] = s.out[1] =
+          newBuffer(w, h, s.active, std::max(s.active.alignment, next->active.alignment), 2 * i + 2, 2 * i + 4);
+      next->in[0] = next->in[1] = s.out[0];
+    } else {  // Converted into the next input
+      s.out[0] = s.out[1] = newBuffer(w, h, s.active, s.active.alignment, 2 * i + 2, 2 * i + 3);
+    }
+    snprintf(buf, sizeof(buf), " -> %s (%s) %ux%u", s.name.c_str(), FormatString(s.active), w, h);
+    m_plan += buf;
+  }
+  BAIL_IF_ERR(vfxErr = allocBuffers());
+  snprintf(buf, sizeof(buf), " -> download (%.1f MB of GPU buffers, rather than %.1f MB unshared)",
+           m_planner.arenaBytes() / 1048576., m_planner.separateBytes() / 1048576.);
+  m_plan += buf;
+  m_outWidth = w;
+  m_outHeight = h;
+
+  for (i = 0; i < n; ++i) {
+    Stage& s = *m_stages[i];
+    *failed = (int)i;  // Until it is loaded
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(s.eff, NVVFX_INPUT_IMAGE, s.in[0]));
+    BAIL_IF_ERR(vfxErr = NvVFX_SetImage(s.eff, NVVFX_OUTPUT_IMAGE, s.out[0]));
+    s.boundIn = s.in[0];
+    s.boundOut = s.out[0];
+    if (s.stateful) {
+      if (!s.state) BAIL_IF_ERR(vfxErr = NvVFX_AllocateState(s.eff, &s.state));
+      BAIL_IF_ERR(vfxErr = NvVFX_SetStateObjectHandleArray(s.eff, NVVFX_STATE, &s.state));
+    }
+    BAIL_IF_ERR(vfxErr = loadStage(s, cudaGraph));
+    *failed = -1;
+  }
+
+  // The staging buffer holds the BGR U8 frame on the GPU, on its way up or down; it is allocated for the larger of the
+  // two now, so that transfers do not reallocate it. It is used at every step, so it is not in the arena.
+  BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&m_tmp, m_outWidth, m_outHeight, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 0));
+  BAIL_IF_ERR(vfxErr = NvCVImage_Realloc(&m_tmp, width, height, NVCV_BGR, NVCV_U8, NVCV_CHUNKY, NVCV_GPU, 0));
+bail:
+  return vfxErr;
+}
+
+NvCV_Status EffectChain::upload(const NvCVImage* src, unsigned buf) {
+  Stage& s = *m_stages.front();
+  return NvCVImage_Transfer(src, s.in[buf], White(s.active.componentType) / 255.f, m_stream, &m_tmp);
+}
+
+// Each effect is rebound only when its buffer set changes, which happens only at the ends of the chain.
+NvCV_Status EffectChain::run(unsigned buf) {
+  NvCV_Status vfxErr = NVCV_SUCCESS;
+  for (std::unique_ptr<Stage>& sp : m_stages) {
+    Stage& s = *sp;
+    if (s.convertFrom) BAIL_IF_ERR(vfxErr = NvCVImage_Transfer(s.convertFrom, s.in[buf], s.convertScale, m_stream,
+                                                               &m_tmp));
+    if (s.boundIn != s.in[buf] || s.boundOut != s.out[buf]) {
+      BAIL_IF_ERR(vfxErr = NvVFX_SetImage(s.eff, NVVFX_INPUT_IMAGE, s.in[buf]));
+      BAIL_IF_ERR(vfxErr = NvVFX_SetImage(s.eff, NVVFX_OUTPUT_IMAGE, s.out[buf]));
+      s.boundIn = s.in[buf];
+      s.boundOut = s.out[buf];
+    }
+    BAIL_IF_ERR(vfxErr = NvVFX_Run(s.eff, 0));
+  }
+bail:
+  return vfxErr;
+}
+
+NvCV_Status EffectChain::download(unsigned buf, NvCVImage* dst) {
+  Stage& s = *m_stages.back();
+  return NvCVImage_Transfer(s.out[buf], dst, 255.f / White(s.active.componentType), m_stream, &m_tmp);
+}
+
+void EffectChain::destroy() {
+  for (std::unique_ptr<Stage>& s : m_stages) {
+    if (s->state) NvVFX_DeallocateState(s->eff, s->state);
+    NvVFX_DestroyEffect(s->eff);
+  }
+  m_stages.clear();
+  m_buffers.clear();
+  m_planner.clear();
+  NvCVImage_Dealloc(&m_arena);
+  if (m_stream) {
+    NvVFX_CudaStreamDestroy(m_stream);
+    m_stream = nullptr;
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __EFFECT_CHAIN_H__
+#define __EFFECT_CHAIN_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bufferPlanner.h"
+#include "nvVideoEffects.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Runs a chain of video effects, e.g. Denoising --> SuperRes --> Upscale, on one CUDA stream,  ///
+/// so that a frame is uploaded once, passes through every effect on the GPU, and is downloaded ///
+/// once. The pixel format of each effect is declared when it is added. When the chain is       ///
+/// loaded, adjacent effects with the same format share a GPU buffer, the output of one being   ///
+/// the input of the next; a conversion on the GPU is inserted only where the formats differ.   ///
+/// The input of the first effect and the output of the last are double-buffered, unless the    ///
+/// effects replay CUDA graphs, so that one frame can be uploaded while another is downloaded.  ///
+/// All of the buffers are carved from one GPU arena, and buffers that are never live at the     ///
+/// same time, within a frame, share memory.                                                     ///
+/// Effects that take F32 images can be given F16 images instead, where they accept them, which ///
+/// halves the memory and bandwidth of the buffers between them; the frame is then converted    ///
+/// only where it is uploaded and downloaded, and where it passes to an effect of another type. ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class EffectChain {
+ public:
+  /// The format of the images that an effect takes and produces, which are the same except for their size.
+  struct Format {
+    NvCVImage_PixelFormat pixelFormat;      ///< e.g. NVCV_BGR or NVCV_RGBA.
+    NvCVImage_ComponentType componentType;  ///< NVCV_U8, in [0, 255], or NVCV_F32, in [0, 1].
+    unsigned layout;                        ///< NVCV_CHUNKY or NVCV_PLANAR.
+    unsigned alignment;                     ///< The row alignment that the effect requires.
+  };
+
+  EffectChain();
+  ~EffectChain();
+
+  /// Create an effect and append it to the chain. Its parameters can then be set with effect(), before load().
+  /// @param[in]  selector   the effect selector, e.g. NVVFX_FX_DENOISING.
+  /// @param[in]  format     the format of the effect's input and output.
+  /// @param[in]  outHeight  the height to which the effect scales its input, or 0 if it does not scale.
+  /// @param[in]  stateful   true if the effect keeps temporal state, which the chain allocates for it.
+  /// @return     NVCV_SUCCESS  if the effect was created.
+  NvCV_Status addStage(const char* selector, const Format& format, unsigned outHeight, bool stateful);
+
+  /// Get the handle of an effect in the chain.
+  NvVFX_Handle effect(unsigned i) const { return m_stages[i]->eff; }
+
+  /// Get the number of effects in the chain.
+  unsigned numStages() const { return (unsigned)m_stages.size(); }
+
+  /// Allocate the buffers for the chain, bind them, and load every effect.
+  /// @param[in]  width          the width of the input frames.
+  /// @param[in]  height         the height of the input frames.
+  /// @param[in]  cudaGraph      true to replay each effect from a CUDA graph, where the effect supports it.
+  /// @param[in]  halfPrecision  true to give NVCV_F16 images to the effects whose format is NVCV_F32, where the effect
+  ///                            accepts them.
+  /// @return     NVCV_SUCCESS  if the chain is ready to run.
+  NvCV_Status load(unsigned width, unsigned height, bool cudaGraph, bool halfPrecision = false);
+
+  /// Upload a frame to the input of the first effect.
+  /// @param[in]  src  a BGR U8 image, on the CPU.
+  /// @param[in]  buf  the buffer set, 0 or 1.
+  NvCV_Status upload(const NvCVImage* src, unsigned buf);
+
+  /// Queue every effect, and the conversions between them, on the stream. This does not wait for them to finish.
+  /// @param[in]  buf  the buffer set, 0 or 1.
+  NvCV_Status run(unsigned buf);
+
+  /// Download the output of the last effect. A download into pageable memory waits for everything queued before it.
+  /// @param[in]  buf  the buffer set, 0 or 1.
+  /// @param[out] dst  a BGR U8 image, on the CPU, of the output size.
+  NvCV_Status download(unsigned buf, NvCVImage* dst);
+
+  /// Determine whether there are two sets of input and output buffers, rather than one.
+  bool doubleBuffered() const { return m_numBufs > 1; }
+
+  /// Get the size of the output of the last effect.
+  unsigned outputWidth() const { return m_outWidth; }
+  unsigned outputHeight() const { return m_outHeight; }
+
+  /// Get the number of format conversions that the chain needs between its effects.
+  unsigned numConversions() const { return m_numConversions; }
+
+  /// Get a description of the chain, as loaded: its effects, buffers and conversions.
+  const std::string& plan() const { return m_plan; }
+
+  /// Destroy the effects and their buffers.
+  void destroy();
+
+ private:
+  struct Stage {
+    std::string name;               ///< The effect selector.
+    NvVFX_Handle eff;               ///< The effect.
+    Format format;                  ///< The format of its input and output, as declared.
+    Format active;                  ///< The format of the buffers that it was given.
+    bool half;                      ///< It is tried with F16 images, in place of F32.
+    unsigned outHeight;             ///< The height of its output, or 0 if the same as its input.
+    bool stateful;                  ///< The effect keeps temporal state.
+    NvVFX_StateObjectHandle state;  ///< The state, if any.
+    NvCVImage* in[2];               ///< The input for each buffer set; the two are the same, except for the first.
+    NvCVImage* out[2];              ///< The output for each buffer set; the two are the same, except for the last.
+    const NvCVImage* convertFrom;   ///< If not NULL, the previous output, which is converted into the input.
+    float convertScale;             ///< The scale applied by the conversion.
+    const NvCVImage* boundIn;       ///< The input bound to the effect.
+    const NvCVImage* boundOut;      ///< The output bound to the effect.
+  };
+
+  struct Buffer {
+    NvCVImage image;         ///< The image, in the arena.
+    unsigned width, height;  ///< The size of the image.
+    Format format;           ///< The format of the image.
+    int pitch;               ///< The bytes per row.
+    unsigned index;          ///< The index of the buffer in the plan.
+  };
+  enum { arenaAlignment = 256 };  ///< The alignment of each buffer in the arena.
+
+  NvCVImage* newBuffer(unsigned width, unsigned height, const Format& format, unsigned alignment, unsigned firstStep,
+                       unsigned lastStep);
+  NvCV_Status allocBuffers();
+  NvCV_Status loadStage(Stage& s, bool cudaGraph);
+  NvCV_Status loadStages(unsigned width, unsigned height, bool cudaGraph, int* failed);
+
+  std::vector<std::unique_ptr<Stage>> m_stages;       ///< The effects, in the order that they are run.
+  std::vector<std::unique_ptr<Buffer>> m_buffers;     ///< The GPU buffers of the effects.
+  BufferPlanner m_planner;                            ///< The layout of the buffers in the arena.
+  NvCVImage m_arena;                                  ///< The GPU memory of all of the buffers.
+  NvCVImage m_tmp;                                    ///< The staging buffer for transfers.
+  CUstream m_stream;                                  ///< The stream on which every effect runs.
+  unsigned m_numBufs;                                 ///< The number of input and output buffer sets.
+  unsigned m_outWidth, m_outHeight;                   ///< The size of the output.
+  unsigned m_numConversions;                          ///< The number of conversions between effects.
+  std::string m_plan;                                 ///< A description of the chain.
+};
+
+#endif  // __EFFECT_CHAIN_H__
@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef __FRAME_GRAPH_H__
+#define __FRAME_GRAPH_H__
+
+#include <functional>
+#include <utility>
+
+#include "appLog.h"
+#include "nvCVImage.h"
+
+#ifdef HAVE_CUDA_RUNTIME
+#include <cuda_runtime_api.h>
+#endif  // HAVE_CUDA_RUNTIME
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Captures the work of one frame -- its upload, effect, composite and download -- from a       ///
+/// stream into a CUDA graph, and replays it with a single launch per frame. A graph replays the ///
+/// same addresses, so each set of buffers that the frames alternate between has its own graph,  ///
+/// and none of them may move or be reallocated once it is captured; the host side of a graph    ///
+/// must be pinned. Parameters that are read when the work is enqueued, such as an effect's      ///
+/// strength, are frozen into the graph, so it is captured again when they change.               ///
+///                                                                                              ///
+/// Capture is thread-local, so other threads may keep allocating and launching while a frame is ///
+/// captured. Graphs need the CUDA runtime, which the apps link when CMake finds the CUDA        ///
+/// toolkit (HAVE_CUDA_RUNTIME); without it, or if any step of the frame cannot be captured,     ///
+/// capture() fails and the caller launches the frame's work individually instead.               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class FrameGraph {
+ public:
+  typedef std::function<NvCV_Status()> Sequence;  ///< Enqueues the work of one frame on the stream
+
+  FrameGraph() : m_exec(nullptr) {}
+  ~FrameGraph() { reset(); }
+  FrameGraph(const FrameGraph&) = delete;
+  FrameGraph& operator=(const FrameGraph&) = delete;
+
+  /// Whether frame graphs were compiled in.
+  /// @return     true if the app was built with the CUDA runtime.
+  static bool Supported() {
+#ifdef HAVE_CUDA_RUNTIME
+    return true;
+#else   // !HAVE_CUDA_RUNTIME
+    return false;
+#endif  // HAVE_CUDA_RUNTIME
+  }
+
+  /// Capture the work of one frame, replacing any graph that was captured before. Nothing is executed; the work is
+  /// only recorded, so the sequence should have been run once eagerly to allocate its temporary buffers and bind its
+  /// images before it is captured.
+  /// @param[in]  stream    the stream that the sequence enqueues all of its work on.
+  /// @param[in]  sequence  enqueues the work of one frame.
+  /// @return     NVCV_SUCCESS if the graph is ready to launch, or the error of the sequence or of the capture.
+  NvCV_Status capture(CUstream stream, const Sequence& sequence) {
+#ifdef HAVE_CUDA_RUNTIME
+    NvCV_Status status;
+    cudaGraph_t graph = nullptr;
+    cudaError_t err;
+
+    reset();
+    err = cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal);
+    if (cudaSuccess != err) return FromCuda(err, "begin");
+    status = sequence();
+    err = cudaStreamEndCapture(stream, &graph);  // Always end the capture, even if the sequence failed
+    if (NVCV_SUCCESS == status && cudaSuccess != err) status = FromCuda(err, "end");
+    if (NVCV_SUCCESS == status) {
+      err = cudaGraphInstantiateWithFlags(&m_exec, graph, 0);
+      if (cudaSuccess != err) {
+        m_exec = nullptr;
+        status = FromCuda(err, "instantiate");
+      }
+    }
+    if (graph) cudaGraphDestroy(graph);
+    if (NVCV_SUCCESS != status) (void)cudaGetLastError();  // A failed capture must not be reported by a later call
+    return status;
+#else   // !HAVE_CUDA_RUNTIME
+    (void)stream;
+    (void)sequence;
+    return NVCV_ERR_UNIMPLEMENTED;
+#endif  // HAVE_CUDA_RUNTIME
+  }
+
+  /// Replay the captured frame, asynchronously.
+  /// @param[in]  stream  the stream to launch the graph on.
+  /// @return     NVCV_SUCCESS if the graph was launched.
+  NvCV_Status launch(CUstream stream) const {
+    if (!m_exec) return NVCV_ERR_MISSINGINPUT;
+#ifdef HAVE_CUDA_RUNTIME
+    return FromCuda(cudaGraphLaunch(m_exec, stream), "launch");
+#else   // !HAVE_CUDA_RUNTIME
+    (void)stream;
+    return NVCV_ERR_UNIMPLEMENTED;
+#endif  // HAVE_CUDA_RUNTIME
+  }
+
+  /// Wait for everything on a stream, including the frame graphs launched on it, to finish.
+  /// @param[in]  stream  the stream.
+  /// @return     NVCV_SUCCESS if the work finished without error.
+  static NvCV_Status Synchronize(CUstream stream) {
+#ifdef HAVE_CUDA_RUNTIME
+    return FromCuda(cudaStreamSynchronize(stream), "synchronize");
+#else   // !HAVE_CUDA_RUNTIME
+    (void)stream;
+    return NVCV_ERR_UNIMPLEMENTED;
+#endif  // HAVE_CUDA_RUNTIME
+  }
+
+  /// Whether a graph has been captured and can be launched.
+  bool captured() const { return nullptr != m_exec; }
+
+  /// Release the captured graph, if any.
+  void reset() {
+#ifdef HAVE_CUDA_RUNTIME
+    if (m_exec) cudaGraphExecDestroy(m_exec);
+#endif  // HAVE_CUDA_RUNTIME
+    m_exec = nullptr;
+  }
+
+  /// Exchange graphs with another frame graph, such as that of a standby effect.
+  void swap(FrameGraph& other) { std::swap(m_exec, other.m_exec); }
+
+ private:
+#ifdef HAVE_CUDA_RUNTIME
+  static NvCV_Status FromCuda(cudaError_t err, const char* step) {
+    if (cudaSuccess == err) return NVCV_SUCCESS;
+    APP_LOG_DEBUG("CUDA graph %s: %s\n", step, cudaGetErrorString(err));
+    return (cudaErrorMemoryAllocation == err) ? NVCV_ERR_CUDA_MEMORY : NVCV_ERR_CUDA;
+  }
+
+  cudaGraphExec_t m_exec;  ///< The instantiated graph, or null if none has been captured
+#else                      // !HAVE_CUDA_RUNTIME
+  void* m_exec;            ///< Always null without the CUDA runtime
+#endif                     // HAVE_CUDA_RUNTIME
+};
+
+#endif  // __FRAME_GRAPH_H__
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __FRAME_QUEUE_H__
+#define __FRAME_QUEUE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A bounded, blocking FIFO queue, used to hand frames from one pipeline stage to the next.      ///
+/// Typically it carries pointers to frames that were preallocated up front, and a second queue ///
+/// returns them to the producer when they have been consumed, so no memory is allocated while  ///
+/// frames are flowing. With one producer and one consumer per queue, frame order is preserved. ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+class BoundedQueue {
+ public:
+  /// Constructor
+  /// @param[in]  capacity  the maximum number of items that can be held before push() blocks.
+  explicit BoundedQueue(size_t capacity = 1) : m_capacity(capacity ? capacity : 1), m_closed(false) {}
+
+  /// Append an item to the queue, waiting for space if the queue is full.
+  /// @param[in]  item  the item to append.
+  /// @return     true  if the item was appended; false if the queue was closed.
+  bool push(const T& item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed) return false;
+    m_items.push_back(item);
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  /// Remove the oldest item from the queue, waiting for one to arrive if the queue is empty.
+  /// Items that were pushed before the queue was closed are still delivered.
+  /// @param[out] item  a place to store the item.
+  /// @return     true  if an item was retrieved; false if the queue was closed and is now empty.
+  bool pop(T* item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+    if (m_items.empty()) return false;
+    *item = m_items.front();
+    m_items.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  /// Close the queue, to signal end-of-stream or to abort. All waiting threads are woken.
+  void close() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+  }
+
+  /// Reopen a closed queue and discard its contents, so that it can be used for another stream.
+  void reset() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_items.clear();
+    m_closed = false;
+  }
+
+  /// Get the number of items currently in the queue. This is only a snapshot.
+  size_t size() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_items.size();
+  }
+
+ private:
+  std::deque<T> m_items;               ///< The items in the queue, oldest first.
+  size_t m_capacity;                   ///< The maximum number of items in the queue.
+  bool m_closed;                       ///< No more items will be accepted.
+  std::mutex m_mutex;                  ///< The mutex protecting all of the above.
+  std::condition_variable m_notEmpty;  ///< Signaled when an item is pushed or the queue is closed.
+  std::condition_variable m_notFull;   ///< Signaled when an item is popped or the queue is closed.
+};
+
+#endif  // __FRAME_QUEUE_H__
@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LATENCY_LOG_H__
+#define __LATENCY_LOG_H__
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A per-frame record of glass-to-glass latency. Each frame carries the monotonic time at which ///
+/// it was captured; as it reaches each stage of interest (e.g. encode, display) the time since ///
+/// capture is stamped into that frame's row. At exit, the distribution of each stage is         ///
+/// summarized as percentiles, and the rows can be written as CSV for closer study.             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class LatencyLog {
+ public:
+  typedef std::chrono::steady_clock Clock;
+  enum { maxStages = 4 };
+
+  /// Constructor
+  /// @param[in]  numStages   the number of stages that are stamped, at most maxStages.
+  /// @param[in]  stageNames  the names of the stages, used in the report and as CSV column headers.
+  LatencyLog(unsigned numStages, const char* const* stageNames)
+      : m_numStages(std::min<unsigned>(numStages, maxStages)), m_names(stageNames) {}
+
+  /// Start the row for a frame. The stages stamped after this are attributed to it.
+  /// @param[in]  frameNum     the number of the frame.
+  /// @param[in]  captureTime  the time at which the frame was captured.
+  void beginFrame(unsigned frameNum, Clock::time_point captureTime) {
+    Row row;
+    row.frameNum = frameNum;
+    for (float& ms : row.ms) ms = -1.f;  // Not reached
+    m_rows.push_back(row);
+    m_captureTime = captureTime;
+  }
+
+  /// Record the time from capture until now, for a stage of the current frame.
+  /// @param[in]  stage  the index of the stage.
+  void stamp(unsigned stage) {
+    if (m_rows.empty() || stage >= m_numStages) return;
+    m_rows.back().ms[stage] = std::chrono::duration<float, std::milli>(Clock::now() - m_captureTime).count();
+  }
+
+  /// Compute a percentile of the latency of a stage, over all of the frames that reached it.
+  /// @param[in]  stage  the index of the stage.
+  /// @param[in]  pct    the percentile, in [0, 100].
+  /// @return     the latency in milliseconds, or a negative number if no frame reached the stage.
+  float percentile(unsigned stage, float pct) const {
+    std::vector<float> ms;
+    for (const Row& row : m_rows)
+      if (row.ms[stage] >= 0.f) ms.push_back(row.ms[stage]);
+    if (ms.empty()) return -1.f;
+    size_t n = (size_t)(pct / 100.f * (ms.size() - 1) + .5f);  // Nearest rank
+    std::nth_element(ms.begin(), ms.begin() + n, ms.end());
+    return ms[n];
+  }
+
+  /// Print the p50, p95 and p99 latency of each stage that was reached.
+  /// @param[in]  fd  the file to print to.
+  void report(FILE* fd) const {
+    fprintf(fd, "Latency from capture, over %u frames:\n", (unsigned)m_rows.size());
+    for (unsigned stage = 0; stage < m_numStages; ++stage) {
+      if (percentile(stage, 50.f) < 0.f) continue;
+      fprintf(fd, "  to %-8s p50 %7.2f ms, p95 %7.2f ms, p99 %7.2f ms\n", m_names[stage], percentile(stage, 50.f),
+              percentile(stage, 95.f), percentile(stage, 99.f));
+    }
+  }
+
+  /// Write the latency of every frame as CSV, with a column per stage; a stage not reached is left empty.
+  /// @param[in]  file  the path of the file to be written.
+  /// @return     true  if the file was written successfully.
+  bool writeCSV(const char* file) const {
+    FILE* fd = fopen(file, "w");
+    if (!fd) return false;
+    fprintf(fd, "frame");
+    for (unsigned stage = 0; stage < m_numStages; ++stage) fprintf(fd, ",%s_ms", m_names[stage]);
+    fprintf(fd, "\n");
+    for (const Row& row : m_rows) {
+      fprintf(fd, "%u", row.frameNum);
+      for (unsigned stage = 0; stage < m_numStages; ++stage)
+        if (row.ms[stage] >= 0.f)
+          fprintf(fd, ",%.3f", row.ms[stage]);
+        else
+          fprintf(fd, ",");
+      fprintf(fd, "\n");
+    }
+    return 0 == fclose(fd);
+  }
+
+ private:
+  struct Row {
+    unsigned frameNum;
+    float ms[maxStages];
+  };
+  unsigned m_numStages;             ///< The number of stages.
+  const char* const* m_names;       ///< The names of the stages.
+  std::vector<Row> m_rows;          ///< One row per frame, in the order that they were output.
+  Clock::time_point m_captureTime;  ///< The capture time of the current frame.
+};
+
+#endif  // __LATENCY_LOG_H__
@@ -0,0 +1,151 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LATEST_FRAME_READER_H__
+#define __LATEST_FRAME_READER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "opencv2/opencv.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A frame reader for live sources, where latency matters more than processing every frame.     ///
+/// A capture thread reads frames continuously and overwrites a single-slot mailbox, so that the ///
+/// capture device's own queue never backs up; read() takes the newest frame, and a frame that  ///
+/// is overwritten before it has been taken is counted as dropped. The three frame buffers are   ///
+/// swapped rather than copied, so no memory is allocated once they have been shaped.            ///
+/// Without a capture thread, read() simply reads the next frame, so files lose nothing.         ///
+/// Each frame is stamped with the monotonic time at which it was captured. A file can be        ///
+/// replayed as if it were a camera by pacing the capture thread at the file's frame rate.       ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class LatestFrameReader {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  LatestFrameReader()
+      : m_cap(nullptr), m_paceFps(0.), m_fresh(false), m_done(false), m_stop(false), m_captured(0), m_dropped(0) {}
+  ~LatestFrameReader() { close(); }
+
+  /// Attach to an opened capture device.
+  /// @param[in]  cap         the capture device. It must not be read by anyone else until close() is called.
+  /// @param[in]  latestOnly  if true, capture on a separate thread and deliver only the newest frame;
+  ///                         if false, deliver every frame, as cap->read() would.
+  /// @param[in]  paceFps     if nonzero, the capture thread releases frames no faster than this rate, so that a file
+  ///                         can stand in for a camera.
+  void open(cv::VideoCapture* cap, bool latestOnly, double paceFps = 0.) {
+    close();
+    m_cap = cap;
+    m_paceFps = paceFps;
+    m_fresh = m_done = m_stop = false;
+    m_captured = m_dropped = 0;
+    if (latestOnly) m_thread = std::thread(&LatestFrameReader::captureLoop, this);
+  }
+
+  /// Get the next frame; with a capture thread, this is the newest frame that has not already been delivered.
+  /// @param[out] frame        the frame. Its previous buffer is recycled for capture, so do not keep other references
+  ///                          to it.
+  /// @param[out] captureTime  if not NULL, a place to store the time at which the frame was captured.
+  /// @return     true         if a frame was read; false at the end of the stream.
+  bool read(cv::Mat& frame, Clock::time_point* captureTime = nullptr) {
+    if (!m_thread.joinable()) {
+      if (!m_cap || !m_cap->read(frame)) return false;
+      if (captureTime) *captureTime = Clock::now();
+      ++m_captured;
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_ready.wait(lock, [this] { return m_fresh || m_done; });
+    if (!m_fresh) return false;
+    cv::swap(frame, m_slot);
+    if (captureTime) *captureTime = m_slotTime;
+    m_fresh = false;
+    return true;
+  }
+
+  /// Stop capturing and detach from the capture device.
+  void close() {
+    if (m_thread.joinable()) {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+      }
+      m_thread.join();
+    }
+    m_cap = nullptr;
+  }
+
+  /// Get the number of frames that have been captured.
+  unsigned captured() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_captured;
+  }
+
+  /// Get the number of captured frames that were overwritten by a newer frame before they could be read.
+  unsigned dropped() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_dropped;
+  }
+
+ private:
+  void captureLoop() {
+    Clock::time_point start = Clock::now();
+    for (unsigned n = 0;; ++n) {
+      bool ok = m_cap->read(m_back);  // This blocks for up to a frame period, so it is done without the lock
+      if (ok && m_paceFps > 0.)
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                                  std::chrono::duration<double>(n / m_paceFps)));
+      Clock::time_point now = Clock::now();
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (!ok || m_stop) break;
+      cv::swap(m_back, m_slot);
+      m_slotTime = now;
+      if (m_fresh) ++m_dropped;  // The previous frame was never taken
+      m_fresh = true;
+      ++m_captured;
+      m_ready.notify_one();
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done = true;
+    m_ready.notify_all();
+  }
+
+  cv::VideoCapture* m_cap;          ///< The capture device.
+  double m_paceFps;                 ///< The rate at which a file is replayed, or 0 to capture as fast as possible.
+  cv::Mat m_slot;                   ///< The mailbox, holding the newest frame.
+  Clock::time_point m_slotTime;     ///< The time at which the frame in the mailbox was captured.
+  cv::Mat m_back;                   ///< The frame being captured, owned by the capture thread.
+  bool m_fresh;                     ///< The mailbox holds a frame that has not yet been read.
+  bool m_done;                      ///< The capture thread has finished.
+  bool m_stop;                      ///< The capture thread has been asked to finish.
+  unsigned m_captured;              ///< The number of frames captured.
+  unsigned m_dropped;               ///< The number of frames overwritten before they were read.
+  std::mutex m_mutex;               ///< The mutex protecting all of the above, except m_back.
+  std::condition_variable m_ready;  ///< Signaled when a frame is captured or capture finishes.
+  std::thread m_thread;             ///< The capture thread, if any.
+};
+
+#endif  // __LATEST_FRAME_READER_H__
@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __RENDITION_LADDER_H__
+#define __RENDITION_LADDER_H__
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frameQueue.h"
+#include "opencv2/opencv.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Writes one stream of frames as several renditions of different sizes, e.g. 2160p, 1440p and ///
+/// 1080p, from a single decode and a single run of the effect at the largest size. Each        ///
+/// rendition has its own thread, which downscales the frame and encodes it, so the renditions  ///
+/// are scaled and encoded in parallel. A frame is copied once into a slot of a fixed pool, and  ///
+/// the slot is shared by all of the renditions until the last of them has encoded it, so no    ///
+/// memory is allocated while frames are flowing.                                                ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class RenditionLadder {
+ public:
+  RenditionLadder() : m_started(false) {}
+  ~RenditionLadder() { close(); }
+
+  /// Add a rendition, before start() is called.
+  /// @param[in]  path       the path of the file to be written.
+  /// @param[in]  fourcc     the codec.
+  /// @param[in]  frameRate  the frame rate.
+  /// @param[in]  size       the size of the frames in this rendition.
+  /// @return     true       if the file was opened for writing.
+  bool addRendition(const std::string& path, int fourcc, double frameRate, cv::Size size) {
+    std::unique_ptr<Rendition> r(new Rendition);
+    r->path = path;
+    r->size = size;
+    if (!r->writer.open(path, fourcc, frameRate, size)) return false;
+    m_renditions.push_back(std::move(r));
+    return true;
+  }
+
+  /// Allocate the frame pool and start the encoder threads.
+  /// @param[in]  frameSize  the size of the frames that will be written; this is only a hint.
+  /// @param[in]  depth      the number of frames that can be in flight.
+  void start(cv::Size frameSize, unsigned depth) {
+    if (m_started || m_renditions.empty()) return;
+    if (!depth) depth = 1;
+    m_slots = std::vector<Slot>(depth);
+    m_freeQ.reset(new BoundedQueue<Slot*>(depth));
+    for (Slot& s : m_slots) {
+      s.frame.create(frameSize, CV_8UC3);
+      m_freeQ->push(&s);
+    }
+    for (std::unique_ptr<Rendition>& r : m_renditions) {
+      r->queue.reset(new BoundedQueue<Slot*>(depth));
+      r->thread = std::thread(&RenditionLadder::encodeLoop, this, r.get());
+    }
+    m_started = true;
+  }
+
+  /// Write a frame to all of the renditions. This waits for a free slot if the encoders have fallen behind.
+  /// @param[in]  frame  the frame. It is copied, so it can be reused as soon as this returns.
+  void write(const cv::Mat& frame) {
+    Slot* s;
+    if (!m_started || !m_freeQ->pop(&s)) return;
+    frame.copyTo(s->frame);  // The slot is only reallocated if the resolution has changed
+    s->remaining = (unsigned)m_renditions.size();
+    for (std::unique_ptr<Rendition>& r : m_renditions) r->queue->push(s);
+  }
+
+  /// Finish encoding the frames already written, and close all of the files.
+  void close() {
+    for (std::unique_ptr<Rendition>& r : m_renditions) {
+      if (r->queue) r->queue->close();
+      if (r->thread.joinable()) r->thread.join();
+      r->writer.release();
+    }
+    m_renditions.clear();
+    if (m_freeQ) m_freeQ->close();
+    m_started = false;
+  }
+
+  /// Determine whether any rendition has been added.
+  bool isOpened() const { return !m_renditions.empty(); }
+
+ private:
+  struct Slot {
+    cv::Mat frame;                    ///< The frame at the largest size.
+    std::atomic<unsigned> remaining;  ///< The number of renditions that have yet to encode it.
+  };
+  struct Rendition {
+    std::string path;                            ///< The file being written.
+    cv::Size size;                               ///< The size of the frames in the file.
+    cv::VideoWriter writer;                      ///< The encoder.
+    cv::Mat scaled;                              ///< The frame, scaled to this rendition's size.
+    std::unique_ptr<BoundedQueue<Slot*>> queue;  ///< The frames waiting to be encoded.
+    std::thread thread;                          ///< The thread that scales and encodes.
+  };
+
+  void encodeLoop(Rendition* r) {
+    Slot* s;
+    while (r->queue->pop(&s)) {
+      if (s->frame.size() == r->size) {
+        r->writer.write(s->frame);
+      } else {
+        cv::resize(s->frame, r->scaled, r->size, 0, 0, cv::INTER_AREA);  // Vectorized
+        r->writer.write(r->scaled);
+      }
+      if (0 == --s->remaining) m_freeQ->push(s);  // The last rendition to finish returns the slot
+    }
+  }
+
+  std::vector<std::unique_ptr<Rendition>> m_renditions;  ///< The renditions, largest first.
+  std::vector<Slot> m_slots;                             ///< The frame pool.
+  std::unique_ptr<BoundedQueue<Slot*>> m_freeQ;          ///< The slots that no rendition is using.
+  bool m_started;                                        ///< The encoder threads are running.
+};
+
+#endif  // __RENDITION_LADDER_H__
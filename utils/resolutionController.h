@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __RESOLUTION_CONTROLLER_H__
+#define __RESOLUTION_CONTROLLER_H__
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Chooses the rung of a resolution ladder at which to run an effect, so that a live session    ///
+/// holds its target frame rate on whatever GPU it runs on. The time spent on each frame is      ///
+/// tracked as a moving average. When it exceeds the frame period, the controller steps down a    ///
+/// rung; when the time predicted for the rung above, scaled by its number of pixels, leaves     ///
+/// some headroom, it steps up. A rung is held for a while after each step, and the hold before  ///
+/// stepping up again doubles whenever a step up has to be undone, so the controller settles     ///
+/// instead of oscillating between two rungs.                                                    ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ResolutionController {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  ResolutionController() : m_rung(0), m_switches(0) {}
+
+  /// Start controlling a stream.
+  /// @param[in]  pixels     the number of pixels at each rung, from the smallest to the largest.
+  /// @param[in]  targetFps  the frame rate to be held.
+  /// @param[in]  rung       the rung to start at.
+  void start(const std::vector<double>& pixels, double targetFps, unsigned rung) {
+    m_pixels = pixels;
+    m_frames.assign(pixels.size(), 0u);
+    m_target = 1. / targetFps;
+    m_minHold = (unsigned)(targetFps + .5);  // Hold a rung for a second before stepping up,
+    m_maxHold = 16 * m_minHold;              // or for up to 16 seconds after a retreat;
+    m_downHold = (m_minHold / 4 > 8) ? m_minHold / 4 : 8;  // but step down as soon as the average has settled
+    m_upHold = m_minHold;
+    m_rung = (rung < pixels.size()) ? rung : (unsigned)pixels.size() - 1;
+    m_held = 0;
+    m_cost = 0.;
+    m_switches = 0;
+  }
+
+  /// Record the time taken by a frame, and choose the rung for the next one.
+  /// @param[in]  frameTime  the time spent on the frame, excluding any time spent waiting for it to be captured.
+  /// @return     the rung at which the next frame should be processed.
+  unsigned update(Clock::duration frameTime) {
+    const double headroom = 0.8;  // The fraction of the frame period that the rung above must fit in
+    double t = std::chrono::duration<double>(frameTime).count();
+    ++m_frames[m_rung];
+    m_cost = (m_held++ == 0) ? t : (7. * m_cost + t) / 8.;  // Exponential moving average, restarted at each rung
+    if (m_held < m_downHold) return m_rung;
+    if (m_cost > m_target && m_rung > 0) {  // Too slow: step down
+      if (m_held < m_upHold + m_minHold)    // This rung was only just reached, so wait longer before trying it again
+        m_upHold = (2 * m_upHold < m_maxHold) ? 2 * m_upHold : m_maxHold;
+      step(m_rung - 1);
+    } else if (m_rung + 1 < m_pixels.size() && m_held >= m_upHold &&
+               m_cost * m_pixels[m_rung + 1] / m_pixels[m_rung] < headroom * m_target) {  // Fast enough to step up
+      step(m_rung + 1);
+    } else if (m_held >= m_maxHold) {  // Settled, so a later retreat starts from scratch
+      m_upHold = m_minHold;
+    }
+    return m_rung;
+  }
+
+  /// Get the rung at which frames are being processed.
+  unsigned rung() const { return m_rung; }
+
+  /// Print the number of switches, and the number of frames processed at each rung.
+  /// @param[in]  fd       the file to print to.
+  /// @param[in]  heights  the height of each rung.
+  void report(FILE* fd, const std::vector<int>& heights) const {
+    fprintf(fd, "Resolution switched %u times; frames processed at", m_switches);
+    for (size_t i = 0; i < m_frames.size(); ++i) fprintf(fd, "%s %dp: %u", (i ? "," : ""), heights[i], m_frames[i]);
+    fprintf(fd, "\n");
+  }
+
+ private:
+  void step(unsigned rung) {
+    m_rung = rung;
+    m_held = 0;
+    ++m_switches;
+  }
+
+  std::vector<double> m_pixels;    ///< The number of pixels at each rung.
+  std::vector<unsigned> m_frames;  ///< The number of frames processed at each rung.
+  double m_target;                 ///< The target frame period, in seconds.
+  double m_cost;                   ///< The moving average of the time per frame at this rung, in seconds.
+  unsigned m_rung;                 ///< The current rung.
+  unsigned m_held;                 ///< The number of frames processed since the last switch.
+  unsigned m_minHold;              ///< The number of frames that a rung is held after a switch, before stepping up.
+  unsigned m_downHold;             ///< The number of frames that a rung is held after a switch, before stepping down.
+  unsigned m_upHold;               ///< The number of frames that a rung is held before stepping up.
+  unsigned m_maxHold;              ///< The limit of m_upHold.
+  unsigned m_switches;             ///< The number of switches.
+};
+
+#endif  // __RESOLUTION_CONTROLLER_H__
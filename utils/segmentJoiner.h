@@ -0,0 +1,270 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __SEGMENT_JOINER_H__
+#define __SEGMENT_JOINER_H__
+
+#include <stdio.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frameQueue.h"
+#include "opencv2/opencv.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else  // !_WIN32
+#include <sys/statvfs.h>
+#endif  // _WIN32
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Splits a video into time segments that are processed in parallel, one thread each, and joins ///
+/// their frames, in order, into a single output that is encoded only once. The frames of the    ///
+/// segment being written are handed straight to the writer, through a bounded queue; the frames ///
+/// of later segments, which are produced before the writer can take them, are spilled to part   ///
+/// files next to the output, and are replayed when their turn comes. The part files are encoded ///
+/// losslessly, with FFV1, so the output is still lossy-compressed only once, and the encoding   ///
+/// overlaps the processing.                                                                     ///
+///                                                                                              ///
+/// The part files hold up to all but the first segment. Before the segments start, the free     ///
+/// space on the disk is checked against their projected size, at the compression that FFV1      ///
+/// usually reaches on video, and the join fails at once if it is short. If the disk fills       ///
+/// anyway, a part file replays fewer frames than were spilled to it, which fails the join. A    ///
+/// segment that fails or gives fewer frames than it was asked for also fails the join; its part ///
+/// files are then kept, for diagnosis, and are otherwise removed.                               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class SegmentJoiner {
+ public:
+  /// Processes frames [firstFrame, firstFrame + numFrames) of segment k, passing each to put(); false if it failed.
+  typedef std::function<bool(unsigned k, long long firstFrame, long long numFrames)> Segment;
+  /// Writes the next frame of the joined output; false if it failed.
+  typedef std::function<bool(const cv::Mat& frame)> Write;
+
+  SegmentJoiner() : m_depth(4), m_failed(false) {}
+
+  /// Set the number of frames that the segment being written can get ahead of the writer.
+  void setQueueDepth(unsigned depth) { m_depth = depth ? depth : 1; }
+
+  /// Get the path of the part file of a segment: "out.mp4" --> "out_part1.mkv".
+  static std::string PartPath(const std::string& outFile, unsigned k) {
+    size_t dot = outFile.find_last_of('.'), slash = outFile.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = outFile.size();
+    return outFile.substr(0, dot) + "_part" + std::to_string(k) + ".mkv";
+  }
+
+  /// Project the size of the part files: the frames of all but the first segment, at the compression that FFV1 usually
+  /// reaches on video. Noise, or film grain, compresses less.
+  /// @param[in]  frameSize  the size of the processed frames, which are BGR.
+  /// @param[in]  numFrames  the number of frames that may be spilled.
+  /// @return     the projected number of bytes.
+  static double ProjectedPartBytes(cv::Size frameSize, long long numFrames) {
+    const double losslessRatio = 2.;  // FFV1 usually halves 8-bit video, or better
+    return 3. * frameSize.area() * numFrames / losslessRatio;
+  }
+
+  /// Get the free space on the disk that holds a file.
+  /// @param[in]  file   the file, which need not exist yet.
+  /// @return     the number of bytes available, or -1 if it cannot be found.
+  static double FreeDiskBytes(const std::string& file) {
+    size_t slash = file.find_last_of("/\\");
+    std::string dir = (slash == std::string::npos) ? std::string(".") : file.substr(0, slash + 1);
+#ifdef _WIN32
+    ULARGE_INTEGER avail;
+    if (!GetDiskFreeSpaceExA(dir.c_str(), &avail, nullptr, nullptr)) return -1.;
+    return (double)avail.QuadPart;
+#else   // !_WIN32
+    struct statvfs fs;
+    if (statvfs(dir.c_str(), &fs)) return -1.;
+    return (double)fs.f_bavail * fs.f_frsize;
+#endif  // _WIN32
+  }
+
+  /// Process a video as segments of equal length, each on its own thread, and write their frames in order, on the
+  /// calling thread.
+  /// @param[in]  outFile      the output, next to which the part files are written.
+  /// @param[in]  frameCount   the number of frames in the video.
+  /// @param[in]  frameSize    the size of the processed frames, from which the size of the part files is projected.
+  /// @param[in]  numSegments  the number of segments.
+  /// @param[in]  segment      the function that processes a segment, called once on each thread.
+  /// @param[in]  write        the function that writes the joined frames.
+  /// @return     true         if every segment gave all of its frames, and they were all written; false, before any
+  ///                          segment is started, if the disk does not have room for the part files.
+  bool run(const std::string& outFile, long long frameCount, cv::Size frameSize, unsigned numSegments,
+           const Segment& segment, const Write& write) {
+    std::vector<std::thread> threads;
+    bool ok = true;
+    unsigned k;
+    long long spillable = frameCount - frameCount / numSegments;  // All but the first segment
+    double need = ProjectedPartBytes(frameSize, spillable), avail = FreeDiskBytes(outFile);
+    if (numSegments > 1 && avail >= 0. && avail < need) {
+      fprintf(stderr,
+              "Error: %u segments may need %.1f GB for their part files next to \"%s\", but only %.1f GB is free\n",
+              numSegments, need / 1e9, outFile.c_str(), avail / 1e9);
+      return false;
+    }
+    m_failed = false;
+    m_segs.clear();
+    for (k = 0; k < numSegments; ++k) {
+      m_segs.emplace_back(new Seg(m_depth));
+      Seg& s = *m_segs.back();
+      s.first = frameCount * k / numSegments;
+      s.count = frameCount * (k + 1) / numSegments - s.first;
+      s.path = PartPath(outFile, k);
+      s.live = (0 == k);
+    }
+    for (k = 0; k < numSegments; ++k)
+      threads.emplace_back([this, k, &segment]() {
+        Seg& s = *m_segs[k];
+        finish(k, segment(k, s.first, s.count));
+      });
+    for (k = 0; k < numSegments && ok; ++k) ok = drain(k, write);
+    if (!ok) fail();  // Stop the segments that are still running
+    for (std::thread& t : threads) t.join();
+    for (k = 0; k < numSegments; ++k) {
+      Seg& s = *m_segs[k];
+      s.spill.release();
+      ok = ok && s.ok;
+    }
+    for (k = 0; k < numSegments; ++k) {
+      if (!m_segs[k]->created) continue;
+      if (ok)
+        remove(m_segs[k]->path.c_str());
+      else
+        fprintf(stderr, "Segment %u was spilled to \"%s\", which is kept\n", k, m_segs[k]->path.c_str());
+    }
+    m_segs.clear();
+    return ok;
+  }
+
+  /// Pass the next processed frame of a segment to be joined. This is called on the segment's thread.
+  /// @param[in]  k      the segment.
+  /// @param[in]  frame  the frame, which is copied.
+  /// @return     true   if the frame was taken; false if the join has failed, and the segment should stop.
+  bool put(unsigned k, const cv::Mat& frame) {
+    Seg& s = *m_segs[k];
+    if (m_failed) return false;
+    ++s.received;
+    {
+      std::unique_lock<std::mutex> lock(s.mutex);
+      if (!s.live) {  // The writer has not reached this segment yet
+        if (!s.created) {
+          s.created = OpenPart(&s.spill, s.path, frame);
+          s.size = frame.size();
+          if (!s.created) fprintf(stderr, "Error: Could not create \"%s\" with FFV1\n", s.path.c_str());
+        }
+        if (!s.created || frame.type() != CV_8UC3 || frame.size() != s.size) {
+          if (s.created) fprintf(stderr, "Error: Segment %u changed its frames, which its part file cannot hold\n", k);
+          lock.unlock();
+          fail();
+          return false;
+        }
+        s.spill.write(frame);
+        ++s.spilled;
+        return true;
+      }
+    }
+    return s.queue.push(frame.clone());
+  }
+
+ private:
+  struct Seg {
+    explicit Seg(unsigned depth)
+        : queue(depth), first(0), count(0), received(0), spilled(0), live(false), created(false), ok(false) {}
+    BoundedQueue<cv::Mat> queue;  ///< The frames handed to the writer, once it has reached this segment.
+    std::mutex mutex;             ///< Protects the spill file and live.
+    std::string path;             ///< The path of the part file.
+    long long first;              ///< The first frame of the segment.
+    long long count;              ///< The number of frames in the segment.
+    long long received;           ///< The number of frames put, so far.
+    long long spilled;            ///< The number of frames in the part file.
+    cv::VideoWriter spill;        ///< The part file, while it is being written.
+    cv::Size size;                ///< The size of the frames in the part file.
+    bool live;                    ///< The writer has reached this segment, so its frames are queued, not spilled.
+    bool created;                 ///< The part file was created.
+    bool ok;                      ///< The segment gave all of its frames.
+  };
+
+  // Record the end of a segment, on its thread.
+  void finish(unsigned k, bool ok) {
+    Seg& s = *m_segs[k];
+    s.ok = ok && s.received == s.count;
+    if (ok && !s.ok)
+      fprintf(stderr, "Error: Segment %u gave %lld of its %lld frames\n", k, s.received, s.count);
+    s.queue.close();  // This publishes s.ok to the writer
+    if (!s.ok) fail();
+  }
+
+  // Write the frames of a segment: first those spilled before the writer reached it, then those queued.
+  bool drain(unsigned k, const Write& write) {
+    Seg& s = *m_segs[k];
+    cv::Mat frame;
+    long long spilled;
+    {
+      std::unique_lock<std::mutex> lock(s.mutex);
+      s.live = true;  // From now on, the segment queues its frames, so the part file is complete
+      s.spill.release();
+      spilled = s.spilled;
+    }
+    if (spilled) {
+      cv::VideoCapture part(s.path);
+      long long i = 0;
+      while (i < spilled && part.read(frame) && frame.size() == s.size) {
+        if (!write(frame)) return false;
+        ++i;
+      }
+      if (i < spilled) {
+        fprintf(stderr, "Error: \"%s\" replayed %lld of its %lld frames; the disk may be full\n", s.path.c_str(), i,
+                spilled);
+        return false;
+      }
+    }
+    while (s.queue.pop(&frame))
+      if (!write(frame)) return false;
+    return s.ok && !m_failed;
+  }
+
+  // Abort the join, waking any segment that is waiting for the writer.
+  void fail() {
+    m_failed = true;
+    for (std::unique_ptr<Seg>& s : m_segs) s->queue.close();
+  }
+
+  // Open a part file for frames the size of the first one. FFV1 is lossless, so the frames are replayed exactly, but
+  // only BGR frames can be written to it. The frame rate of a part file is never used.
+  static bool OpenPart(cv::VideoWriter* spill, const std::string& path, const cv::Mat& frame) {
+    return CV_8UC3 == frame.type() && spill->open(path, cv::VideoWriter::fourcc('F', 'F', 'V', '1'), 30., frame.size());
+  }
+
+  unsigned m_depth;                          ///< The capacity of each segment's queue.
+  std::atomic<bool> m_failed;                ///< The join has failed, so the segments should stop.
+  std::vector<std::unique_ptr<Seg>> m_segs;  ///< The segments of the current run().
+};
+
+#endif  // __SEGMENT_JOINER_H__
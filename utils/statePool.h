@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __STATE_POOL_H__
+#define __STATE_POOL_H__
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "nvVideoEffects.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Keeps the state objects of a loaded temporal effect, such as the denoiser, so that a stream ///
+/// of short clips does not allocate and deallocate a state for every clip. The states are       ///
+/// allocated up front; a clip leases one, and gives it back when it is done, whereupon it is    ///
+/// reset, ready for the next clip. If every state is leased, another is allocated and kept in   ///
+/// the pool. The states belong to the effect as it was loaded, so the pool is destroyed before  ///
+/// the effect is reloaded or destroyed. It is not thread-safe.                                  ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class StatePool {
+ public:
+  StatePool() : m_eff(nullptr), m_peak(0), m_leases(0), m_grown(0) {}
+  ~StatePool() { destroy(); }
+
+  /// Allocate the states for an effect. The statistics accumulate over every init().
+  /// @param[in]  eff    the effect, which has been loaded.
+  /// @param[in]  count  the number of states to allocate.
+  /// @return     NVCV_SUCCESS if every state was allocated.
+  NvCV_Status init(NvVFX_Handle eff, unsigned count) {
+    NvCV_Status err = NVCV_SUCCESS;
+    destroy();
+    m_eff = eff;
+    while (count-- && NVCV_SUCCESS == err) err = grow();
+    return err;
+  }
+
+  /// Lease a state, which has been reset. A state is allocated if none is free.
+  /// @param[out] state  the state.
+  /// @return     NVCV_SUCCESS if a state was leased.
+  NvCV_Status lease(NvVFX_StateObjectHandle* state) {
+    if (m_free.empty()) {
+      NvCV_Status err = grow();
+      if (NVCV_SUCCESS != err) return err;
+      ++m_grown;
+    }
+    *state = m_free.back();
+    m_free.pop_back();
+    ++m_leases;
+    m_peak = std::max(m_peak, inUse());
+    return NVCV_SUCCESS;
+  }
+
+  /// Give back a leased state, resetting it for the next lease.
+  /// @param[in]  state  the state.
+  /// @return     NVCV_SUCCESS if the state was reset.
+  NvCV_Status giveBack(NvVFX_StateObjectHandle state) {
+    m_free.push_back(state);
+    return NvVFX_ResetState(m_eff, state);
+  }
+
+  /// Deallocate every state, whether or not it has been given back.
+  void destroy() {
+    for (NvVFX_StateObjectHandle state : m_states) NvVFX_DeallocateState(m_eff, state);
+    m_states.clear();
+    m_free.clear();
+    m_eff = nullptr;
+  }
+
+  unsigned capacity() const { return (unsigned)m_states.size(); }
+  unsigned inUse() const { return (unsigned)(m_states.size() - m_free.size()); }
+  unsigned peakInUse() const { return m_peak; }
+  unsigned leases() const { return m_leases; }
+
+  /// Print the occupancy of the pool.
+  /// @param[in]  fd  the file to print to.
+  void report(FILE* fd) const {
+    fprintf(fd, "%u leases of %u state objects, with at most %u in use at once; %u allocated on demand\n", m_leases,
+            capacity(), m_peak, m_grown);
+  }
+
+ private:
+  NvCV_Status grow() {
+    NvVFX_StateObjectHandle state = nullptr;
+    NvCV_Status err = NvVFX_AllocateState(m_eff, &state);
+    if (NVCV_SUCCESS != err) return err;
+    m_states.push_back(state);
+    m_free.push_back(state);
+    return NVCV_SUCCESS;
+  }
+
+  NvVFX_Handle m_eff;                             ///< The effect that the states belong to.
+  std::vector<NvVFX_StateObjectHandle> m_states;  ///< Every state allocated.
+  std::vector<NvVFX_StateObjectHandle> m_free;    ///< The states that are not leased.
+  unsigned m_peak;                                ///< The most states leased at once.
+  unsigned m_leases;                              ///< The number of leases.
+  unsigned m_grown;                               ///< The number of states allocated because none was free.
+};
+
+#endif  // __STATE_POOL_H__
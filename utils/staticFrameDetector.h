@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __STATIC_FRAME_DETECTOR_H__
+#define __STATIC_FRAME_DETECTOR_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STATIC_FRAME_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define STATIC_FRAME_NEON
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Detects decoded frames that repeat the last frame that was run through an effect, exactly or ///
+/// nearly, as in screen shares and static cameras, so that the effect's last output can be      ///
+/// reused instead of running it again. The frame is divided into tiles of 32x32 pixels, and     ///
+/// the mean absolute difference of every other row of each tile is compared with a threshold,   ///
+/// in 8-bit levels; a small change, such as a moving cursor, thus keeps the frame from being    ///
+/// a repeat, even though it hardly changes the mean over the whole frame. The comparison stops  ///
+/// at the first tile that differs. The reference is the last frame kept, not the last frame     ///
+/// seen, so a slow drift cannot go unnoticed. A temporal effect simply does not see a repeated  ///
+/// frame, so its state stays that of the frame that it last saw, whose output is reused.       ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class StaticFrameDetector {
+ public:
+  StaticFrameDetector() : m_threshold(.5f), m_hasRef(false), m_frames(0), m_repeats(0) {}
+
+  /// Set the largest mean absolute difference, in 8-bit levels, that a tile of a repeated frame may have.
+  void setThreshold(float levels) { m_threshold = levels; }
+
+  /// Forget the reference, so that the next frame is not a repeat, e.g. when the effect's output can no longer be
+  /// reused.
+  void reset() { m_hasRef = false; }
+
+  /// Determine whether a frame repeats the reference, closely enough that the output for the reference can be reused.
+  /// @param[in]  frame  the frame, 8 bits per component.
+  /// @return     true   if the frame is a repeat, and can skip the effect.
+  bool isRepeat(const cv::Mat& frame) {
+    ++m_frames;
+    if (!m_hasRef || frame.size() != m_ref.size() || frame.type() != m_ref.type()) return false;
+    const size_t rowBytes = frame.cols * frame.elemSize(), tileBytes = tileSize * frame.elemSize();
+    m_tileSad.resize((rowBytes + tileBytes - 1) / tileBytes);
+    for (int y0 = 0; y0 < frame.rows; y0 += tileSize) {
+      int y1 = std::min(y0 + (int)tileSize, frame.rows), y;
+      std::fill(m_tileSad.begin(), m_tileSad.end(), 0u);
+      for (y = y0; y < y1; y += rowStep) {
+        const unsigned char *a = frame.ptr<unsigned char>(y), *b = m_ref.ptr<unsigned char>(y);
+        for (size_t t = 0, x = 0; x < rowBytes; ++t, x += tileBytes)
+          m_tileSad[t] += SAD(a + x, b + x, std::min(tileBytes, rowBytes - x));
+      }
+      const double rows = (double)((y1 - y0 + rowStep - 1) / rowStep);
+      for (size_t t = 0, x = 0; x < rowBytes; ++t, x += tileBytes)
+        if (m_tileSad[t] > m_threshold * rows * std::min(tileBytes, rowBytes - x)) return false;
+    }
+    ++m_repeats;
+    return true;
+  }
+
+  /// Keep a frame that is run through the effect, as the reference for the frames after it.
+  /// @param[in]  frame  the frame.
+  void keep(const cv::Mat& frame) {
+    frame.copyTo(m_ref);  // This only allocates if the size changes
+    m_hasRef = true;
+  }
+
+  unsigned frames() const { return m_frames; }
+  unsigned repeats() const { return m_repeats; }
+
+  /// Print the number of frames that repeated the reference, and so skipped the effect.
+  /// @param[in]  fd  the file to print to.
+  void report(FILE* fd) const {
+    fprintf(fd, "%u of %u frames were repeats (%.1f%%), and skipped the effect\n", m_repeats, m_frames,
+            (m_frames ? 100. * m_repeats / m_frames : 0.));
+  }
+
+ private:
+  enum {
+    tileSize = 32,  ///< The width and height of a tile, in pixels.
+    rowStep = 2,    ///< Every rowStep'th row is compared.
+  };
+
+  /// Sum the absolute differences of two rows of bytes.
+  static uint32_t SAD(const unsigned char* a, const unsigned char* b, size_t n) {
+    uint32_t sum = 0;
+    size_t i = 0;
+#if defined(STATIC_FRAME_SSE2)
+    __m128i acc = _mm_setzero_si128();  // Two 64-bit sums
+    for (; i + 16 <= n; i += 16)
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(a + i)),
+                                            _mm_loadu_si128((const __m128i*)(b + i))));
+    sum = (uint32_t)(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(STATIC_FRAME_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= n; i += 16) acc = vpadalq_u16(acc, vpaddlq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i))));
+    sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (; i < n; ++i) sum += (uint32_t)abs((int)a[i] - (int)b[i]);
+    return sum;
+  }
+
+  cv::Mat m_ref;                    ///< The last frame kept.
+  std::vector<uint32_t> m_tileSad;  ///< The sums of absolute differences of one row of tiles.
+  float m_threshold;                ///< The largest mean absolute difference of a tile of a repeat.
+  bool m_hasRef;                    ///< A frame has been kept.
+  unsigned m_frames;                ///< The number of frames examined.
+  unsigned m_repeats;               ///< The number of frames that were repeats.
+};
+
+#endif  // __STATIC_FRAME_DETECTOR_H__
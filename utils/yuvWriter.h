@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __YUV_WRITER_H__
+#define __YUV_WRITER_H__
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "opencv2/opencv.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Writes 4:2:0 YUV frames, as an encoder that takes raw YUV expects them, instead of BGR frames ///
+/// that cv::VideoWriter would convert to YUV itself. The layout follows the file's suffix:      ///
+/// ".y4m" is I420 in a YUV4MPEG2 stream, which x264 and ffmpeg read directly; ".yuv" is raw     ///
+/// I420; and ".nv12" is raw NV12, the layout that NVENC takes. Raw files carry no header, so    ///
+/// the size and frame rate must be given to the encoder, e.g.                                 ///
+///     ffmpeg -f rawvideo -pix_fmt nv12 -s 3840x2160 -r 30 -i out.nv12 ...                     ///
+/// Frames are packed, with the chroma after the luma, in BT.709 video range.                   ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class YUVWriter {
+ public:
+  YUVWriter() : m_fd(nullptr), m_nv12(false), m_y4m(false), m_width(0), m_height(0) {}
+  ~YUVWriter() { close(); }
+
+  /// Determine whether a file should be written as YUV, from its suffix.
+  static bool IsYUVFile(const char* path) {
+    return HasSuffix(path, ".y4m") || HasSuffix(path, ".yuv") || HasSuffix(path, ".nv12");
+  }
+
+  /// Open a file for writing.
+  /// @param[in]  path       the path of the file; its suffix chooses the layout.
+  /// @param[in]  width      the width of the frames, which must be even.
+  /// @param[in]  height     the height of the frames, which must be even.
+  /// @param[in]  frameRate  the frame rate, which is recorded in a ".y4m" file.
+  /// @return     true       if the file was opened.
+  bool open(const char* path, unsigned width, unsigned height, double frameRate) {
+    close();
+    if ((width | height) & 1) return false;
+    m_y4m = HasSuffix(path, ".y4m");
+    m_nv12 = HasSuffix(path, ".nv12");
+    m_width = width;
+    m_height = height;
+    if (!(m_fd = fopen(path, "wb"))) return false;
+    if (m_y4m)  // The chroma is sited between the luma samples, as the CPU conversion below averages 2x2 blocks
+      fprintf(m_fd, "YUV4MPEG2 W%u H%u F%u:1000 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", width, height,
+              (unsigned)(frameRate * 1000. + .5));
+    return true;
+  }
+
+  /// Determine whether the frames are NV12, with the U and V samples interleaved; otherwise they are I420.
+  bool isNV12() const { return m_nv12; }
+
+  /// Determine whether a file is open.
+  bool isOpened() const { return m_fd != nullptr; }
+
+  /// Get the size of a packed frame, in bytes.
+  size_t frameBytes() const { return (size_t)m_width * m_height * 3 / 2; }
+
+  /// Write a frame.
+  /// @param[in]  frame  the packed frame, in the layout that isNV12() reports.
+  /// @return     true   if the frame was written.
+  bool write(const unsigned char* frame) {
+    if (!m_fd) return false;
+    if (m_y4m) fputs("FRAME\n", m_fd);
+    return frameBytes() == fwrite(frame, 1, frameBytes(), m_fd);
+  }
+
+  /// Finish writing.
+  void close() {
+    if (m_fd) fclose(m_fd);
+    m_fd = nullptr;
+  }
+
+  /// Convert a BGR frame to a packed 4:2:0 frame, in BT.709 video range, on the CPU, for when this cannot be done on
+  /// the GPU.
+  /// @param[in]  bgr   the frame, of the size that was opened.
+  /// @param[out] yuv   the packed frame, of frameBytes(), in the layout that isNV12() reports.
+  void convert(const cv::Mat& bgr, unsigned char* yuv) const {
+    unsigned char *Y = yuv, *U = yuv + m_width * m_height, *V = U + (m_nv12 ? 1 : m_width * m_height / 4);
+    unsigned uvStep = m_nv12 ? 2 : 1, x, y;
+    for (y = 0; y < m_height; y += 2) {
+      const unsigned char *p0 = bgr.ptr<unsigned char>(y), *p1 = bgr.ptr<unsigned char>(y + 1);
+      for (x = 0; x < m_width; x += 2, p0 += 6, p1 += 6, U += uvStep, V += uvStep) {
+        int b = 0, g = 0, r = 0;
+        const unsigned char* px[4] = {p0, p0 + 3, p1, p1 + 3};
+        for (unsigned i = 0; i < 4; ++i) {
+          Y[(y + (i >> 1)) * m_width + x + (i & 1)] = Luma(px[i][0], px[i][1], px[i][2]);
+          b += px[i][0];
+          g += px[i][1];
+          r += px[i][2];
+        }
+        // BT.709 video range, with 8 fractional bits; the sums are 4 times the mean
+        *U = (unsigned char)((-26 * r - 86 * g + 112 * b + 4 * 128 * 256 + 512) >> 10);
+        *V = (unsigned char)((112 * r - 102 * g - 10 * b + 4 * 128 * 256 + 512) >> 10);
+      }
+    }
+  }
+
+ private:
+  static bool HasSuffix(const char* path, const char* suf) {
+    size_t len = strlen(path), n = strlen(suf);
+    if (len < n) return false;
+    for (path += len - n; *suf; ++path, ++suf)
+      if (tolower((unsigned char)*path) != *suf) return false;
+    return true;
+  }
+
+  static unsigned char Luma(int b, int g, int r) {
+    return (unsigned char)((47 * r + 157 * g + 16 * b + 16 * 256 + 128) >> 8);
+  }
+
+  FILE* m_fd;         ///< The file being written.
+  bool m_nv12;        ///< The frames are NV12, rather than I420.
+  bool m_y4m;         ///< The file is a YUV4MPEG2 stream.
+  unsigned m_width;   ///< The width of the frames.
+  unsigned m_height;  ///< The height of the frames.
+};
+
+#endif  // __YUV_WRITER_H__